@@ -0,0 +1,85 @@
+#include "DiagramMinimap.h"
+#include "DiagramView.h"
+#include <QGraphicsScene>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QTimer>
+
+DiagramMinimap::DiagramMinimap(DiagramView* view, QWidget* parent)
+    : QWidget(parent), view_(view)
+{
+    setMinimumSize(120, 90);
+    setCursor(Qt::PointingHandCursor);
+
+    refreshTimer_ = new QTimer(this);
+    refreshTimer_->setInterval(kRefreshMs);
+    connect(refreshTimer_, &QTimer::timeout, this, &DiagramMinimap::refresh);
+
+    // mudança de sceneRect altera a escala: refaz já, sem esperar o timer
+    connect(view_->scene(), &QGraphicsScene::sceneRectChanged, this, [this](){ if (isVisible()) refresh(); });
+    connect(view_, &DiagramView::viewChanged, this, [this](){ update(); });   // só o retângulo
+}
+
+QTransform DiagramMinimap::sceneToMap() const {
+    const QRectF sr = view_->scene()->sceneRect();
+    QTransform t;
+    if (sr.width() <= 0 || sr.height() <= 0) return t;
+    const qreal s = qMin(width() / sr.width(), height() / sr.height());
+    t.translate((width() - sr.width() * s) / 2.0, (height() - sr.height() * s) / 2.0);
+    t.scale(s, s);
+    t.translate(-sr.left(), -sr.top());
+    return t;
+}
+
+void DiagramMinimap::refresh(){
+    if (cache_.size() != size()) cache_ = QPixmap(size());
+    if (cache_.isNull()) return;
+
+    // na escala do minimapa os itens quase não pintam (nível de detalhe da cena)
+    const QRectF target(cache_.rect());
+    QPainter p(&cache_);
+    p.fillRect(target, palette().base());
+    view_->scene()->render(&p, target, sceneToMap().inverted().mapRect(target), Qt::IgnoreAspectRatio);
+    p.end();
+    update();
+}
+
+void DiagramMinimap::paintEvent(QPaintEvent*){
+    QPainter p(this);
+    if (cache_.size() != size()) p.fillRect(rect(), palette().base());   // refresh() a caminho
+    else p.drawPixmap(0, 0, cache_);
+
+    p.setPen(QPen(QColor(200, 40, 40), 1.5));
+    p.setBrush(QColor(200, 40, 40, 30));
+    p.drawRect(sceneToMap().mapRect(view_->visibleSceneRect()));
+}
+
+void DiagramMinimap::resizeEvent(QResizeEvent* e){
+    QWidget::resizeEvent(e);
+    if (isVisible()) refresh();
+}
+
+void DiagramMinimap::showEvent(QShowEvent* e){
+    QWidget::showEvent(e);
+    refresh();
+    refreshTimer_->start();
+}
+
+void DiagramMinimap::hideEvent(QHideEvent* e){
+    QWidget::hideEvent(e);
+    refreshTimer_->stop();   // dock fechado ou flutuando minimizado: nada a pintar
+}
+
+void DiagramMinimap::centerViewAt(const QPoint& pos){
+    bool ok = false;
+    const QTransform inv = sceneToMap().inverted(&ok);
+    if (ok) view_->centerOn(inv.map(QPointF(pos)));
+}
+
+void DiagramMinimap::mousePressEvent(QMouseEvent* e){
+    if (e->button() == Qt::LeftButton) centerViewAt(e->pos());
+}
+
+void DiagramMinimap::mouseMoveEvent(QMouseEvent* e){
+    if (e->buttons() & Qt::LeftButton) centerViewAt(e->pos());
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <QWidget>
+#include <QPixmap>
+class DiagramView;
+class QTimer;
+
+// Visão geral da cena inteira num pixmap de baixa resolução, com o retângulo
+// visível da view principal por cima; clicar/arrastar centraliza a view.
+// O pixmap é refeito por um timer de kRefreshMs, só enquanto o widget está
+// visível; não se liga a QGraphicsScene::changed, que obrigaria a cena a
+// calcular as regiões alteradas a cada atualização e atrapalharia a view
+// principal. Zoom/rolagem só repintam o retângulo.
+class DiagramMinimap : public QWidget {
+    Q_OBJECT
+public:
+    explicit DiagramMinimap(DiagramView* view, QWidget* parent = nullptr);
+
+    static constexpr int kRefreshMs = 500;
+    QSize sizeHint() const override { return { 240, 180 }; }
+
+protected:
+    void paintEvent(QPaintEvent* e) override;
+    void resizeEvent(QResizeEvent* e) override;
+    void showEvent(QShowEvent* e) override;
+    void hideEvent(QHideEvent* e) override;
+    void mousePressEvent(QMouseEvent* e) override;
+    void mouseMoveEvent(QMouseEvent* e) override;
+
+private:
+    void refresh();
+    QTransform sceneToMap() const;   // sceneRect -> widget, mantendo a proporção
+    void centerViewAt(const QPoint& p);
+
+    DiagramView* view_;
+    QPixmap cache_;
+    QTimer* refreshTimer_ = nullptr;
+};
@@ -6,8 +6,183 @@
 #include <QPen>
 #include <QGraphicsView>   // <- necessário para scene()->views().first()
 #include <QWidget>         // opcional, só para o tipo QWidget*
+#include <QTimer>
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <algorithm>
+#include <cmath>
 
-DiagramScene::DiagramScene(QObject* parent) : QGraphicsScene(parent) {}
+namespace { const QRectF kInitialSceneRect(-400, -300, 800, 600); }
+
+DiagramScene::DiagramScene(QObject* parent) : QGraphicsScene(parent) {
+    frameTimer_ = new QTimer(this);
+    frameTimer_->setSingleShot(true);
+    frameTimer_->setTimerType(Qt::PreciseTimer);
+    frameTimer_->setInterval(kFrameMs);
+    connect(frameTimer_, &QTimer::timeout, this, &DiagramScene::flushGeometry);
+    setSceneRect(kInitialSceneRect);   // cresce em growToInclude()
+    adjustIndexDepth();
+}
+
+DiagramScene* DiagramScene::of(const QGraphicsItem* item){
+    return (item && item->scene()) ? qobject_cast<DiagramScene*>(item->scene()) : nullptr;
+}
+
+namespace {
+// remove sem deslocar o vetor (busca do fim: itens recentes); a ordem não importa
+template <typename T>
+bool swapRemove(QVector<T*>& v, T* item){
+    const int i = v.lastIndexOf(item);
+    if (i < 0) return false;
+    v[i] = v.back();
+    v.pop_back();
+    return true;
+}
+}
+
+void DiagramScene::registerState(StateItem* s){
+    states_.push_back(s);
+    s->setLabelVisible(labelsShown_);
+    growToInclude(s->sceneBoundingRect());
+    adjustIndexDepth();
+    emit modelChanged();
+}
+
+void DiagramScene::unregisterState(StateItem* s){
+    if (swapRemove(states_, s)) { adjustIndexDepth(); emit modelChanged(); }
+}
+
+void DiagramScene::registerTransition(TransitionItem* t){
+    transitions_.push_back(t);
+    t->setLabelVisible(labelsShown_);
+    bundleInsert(t);
+    adjustIndexDepth();
+    emit transitionAdded(t);
+}
+
+void DiagramScene::unregisterTransition(TransitionItem* t){
+    bundleErase(t);
+    if (t->pathDirty_) { t->pathDirty_ = false; swapRemove(dirty_, t); }
+    if (swapRemove(transitions_, t)) { adjustIndexDepth(); emit transitionRemoved(t); }
+}
+
+void DiagramScene::bundleInsert(TransitionItem* t){
+    if (!t->src() || !t->dst()) return;
+    const BundleKey key = t->src() < t->dst() ? BundleKey(t->src(), t->dst()) : BundleKey(t->dst(), t->src());
+    EdgeBundle& b = bundles_[key];
+    auto& side = t->src() == key.first ? b.fwd : b.back;
+    const auto at = std::lower_bound(side.begin(), side.end(), t,
+                                     [](const TransitionItem* x, const TransitionItem* y){ return x->id() < y->id(); });
+    side.insert(at, t);
+    bundleOf_.insert(t, key);
+    layoutBundle(b);
+    t->invalidatePath();   // nova ou com extremos novos: ainda sem traçado válido
+}
+
+void DiagramScene::bundleErase(TransitionItem* t){
+    const auto it = bundleOf_.find(t);
+    if (it == bundleOf_.end()) return;
+    const auto bi = bundles_.find(it.value());
+    bundleOf_.erase(it);
+    if (bi == bundles_.end()) return;
+    bi->fwd.removeOne(t);    // preserva a ordem de id
+    bi->back.removeOne(t);
+    if (bi->fwd.isEmpty() && bi->back.isEmpty()) bundles_.erase(bi);
+    else layoutBundle(*bi);
+}
+
+void DiagramScene::layoutBundle(const EdgeBundle& b){
+    const bool bidir = !b.fwd.isEmpty() && !b.back.isEmpty();
+    for (int i=0; i<b.fwd.size(); ++i)  b.fwd[i]->setBundleSlot(i, b.fwd.size(), bidir);
+    for (int i=0; i<b.back.size(); ++i) b.back[i]->setBundleSlot(i, b.back.size(), bidir);
+}
+
+void DiagramScene::markGeometryDirty(TransitionItem* t){
+    if (t->pathDirty_) return;
+    t->pathDirty_ = true;
+    dirty_.push_back(t);
+    if (batchDepth_ == 0 && !frameTimer_->isActive()) frameTimer_->start();
+}
+
+void DiagramScene::flushGeometry(){
+    frameTimer_->stop();
+    const QVector<TransitionItem*> dirty = std::move(dirty_);
+    dirty_.clear();
+    for (TransitionItem* t : dirty){
+        t->pathDirty_ = false;
+        t->updatePath();
+    }
+}
+
+void DiagramScene::setViewScale(qreal scale){
+    const bool show = scale >= kLodLabels;
+    if (show == labelsShown_) return;   // só ao cruzar o limiar
+    labelsShown_ = show;
+    for (StateItem* s : states_) s->setLabelVisible(show);
+    for (TransitionItem* t : transitions_) t->setLabelVisible(show);
+}
+
+void DiagramScene::growToInclude(const QRectF& r){
+    const QRectF cur = sceneRect();
+    const QRectF need = r.adjusted(-kSceneMargin, -kSceneMargin, kSceneMargin, kSceneMargin);
+    if (cur.contains(need)) return;
+    // folga de 1/4 do novo tamanho no lado que estourou
+    QRectF g = cur.united(need);
+    const qreal dx = g.width() / 4, dy = g.height() / 4;
+    g.adjust(need.left()  < cur.left()  ? -dx : 0, need.top()    < cur.top()    ? -dy : 0,
+             need.right() > cur.right() ?  dx : 0, need.bottom() > cur.bottom() ?  dy : 0);
+    setSceneRect(g);
+}
+
+void DiagramScene::adjustIndexDepth(){
+    const int n = states_.size() + transitions_.size();
+    const int depth = qBound(5, int(std::ceil(std::log2(qMax(1, n) / qreal(kItemsPerLeaf)))), 16);
+    // mudar a profundidade refaz o índice: cresce de imediato, encolhe só com
+    // dois níveis de folga (não oscila em torno de uma potência de 2)
+    const int cur = bspTreeDepth();
+    if (depth > cur || depth < cur - 1) setBspTreeDepth(depth);
+}
+
+void DiagramScene::drawForeground(QPainter* p, const QRectF& rect){
+    const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(p->worldTransform());
+    if (lod >= kLodAggregate || lod <= 0) return;
+
+    // visão geral: um quadrado por célula ocupada, mais escuro quanto mais estados
+    const qreal cell = kAggregateCellPx / lod;
+    QHash<quint64, int> counts;
+    for (StateItem* s : states_){
+        const QPointF c = s->scenePos();
+        if (!rect.contains(c)) continue;
+        const auto cx = quint32(qint32(std::floor(c.x() / cell)));
+        const auto cy = quint32(qint32(std::floor(c.y() / cell)));
+        ++counts[(quint64(cx) << 32) | cy];
+    }
+    p->save();
+    p->setRenderHint(QPainter::Antialiasing, false);
+    p->setPen(Qt::NoPen);
+    for (auto it = counts.cbegin(); it != counts.cend(); ++it){
+        const qreal x = qint32(quint32(it.key() >> 32)) * cell;
+        const qreal y = qint32(quint32(it.key())) * cell;
+        p->setBrush(QColor(40, 50, 140, qMin(255, 70 + 30 * it.value())));
+        p->drawRect(QRectF(x, y, cell, cell));
+    }
+    p->restore();
+}
+
+void DiagramScene::clearDiagram(){
+    // esvazia os registros antes, para que os destrutores não os percorram
+    states_.clear();
+    transitions_.clear();
+    bundles_.clear();
+    bundleOf_.clear();
+    dirty_.clear();
+    frameTimer_->stop();
+    setMode(mode_);   // descarta linha temporária, se houver
+    clear();
+    setSceneRect(kInitialSceneRect);
+    adjustIndexDepth();
+    emit modelChanged();
+}
 
 void DiagramScene::setMode(Mode m){
     mode_ = m;
@@ -56,19 +231,7 @@ void DiagramScene::mouseReleaseEvent(QGraphicsSceneMouseEvent* e){
         // >>> Agora PERMITIMOS self-loop (dst == pendingSrc_)
         if (pendingSrc_ && dst){
             auto* t = new TransitionItem(pendingSrc_, dst);
-            addItem(t);
-            t->updatePath();
-
-            // Reposiciona todos os self-loops desse estado
-            if (pendingSrc_ == dst) {
-                for (QGraphicsItem* gi : items()){
-                    if (auto tr = dynamic_cast<TransitionItem*>(gi)){
-                        if (tr->src() == pendingSrc_ && tr->dst() == dst) {
-                            tr->updatePath(); // recomputa ângulo/controle conforme nova contagem
-                        }
-                    }
-                }
-            }
+            addItem(t);   // registerTransition redistribui o feixe (paralelas/self-loops)
 
             // Abre o editor para preencher prioridade/guarda/ação/label
             QWidget* parentWidget = nullptr;
@@ -88,6 +251,7 @@ void DiagramScene::mouseReleaseEvent(QGraphicsSceneMouseEvent* e){
         return;
     }
     QGraphicsScene::mouseReleaseEvent(e);
+    flushGeometry();   // fim do arraste: geometria final sem esperar o quadro
 }
 
 
@@ -1,6 +1,10 @@
 #pragma once
 #include <QGraphicsScene>
+#include <QHash>
+#include <QPair>
+#include <QVector>
 
+class QTimer;
 class StateItem;
 class TransitionItem;
 
@@ -14,15 +18,108 @@ public:
     void setMode(Mode m);
     Mode mode() const { return mode_; }
 
+    // Cena "dona" do item (nullptr se fora de uma DiagramScene)
+    static DiagramScene* of(const QGraphicsItem* item);
+
+    // Registro dos itens do EFSM, mantido pelos próprios itens ao entrar/sair
+    // da cena (evita varrer items() + dynamic_cast).
+    const QVector<StateItem*>&      states()      const { return states_; }
+    const QVector<TransitionItem*>& transitions() const { return transitions_; }
+    void registerState(StateItem* s);
+    void unregisterState(StateItem* s);
+    void registerTransition(TransitionItem* t);
+    void unregisterTransition(TransitionItem* t);
+    void clearDiagram();   // remove e apaga todos os itens
+
+    // Feixes de arestas por par de estados (não ordenado), em ordem de id:
+    // dão a cada transição seu índice entre as paralelas/self-loops sem varrer
+    // a cena. Só o feixe que muda (inclusão ou remoção) é redistribuído.
+    struct EdgeBundle {
+        QVector<TransitionItem*> fwd;    // lo -> hi; self-loops ficam todos aqui
+        QVector<TransitionItem*> back;   // hi -> lo
+    };
+
+    // Geometria adiada: arestas marcadas são recalculadas uma vez por quadro
+    // (kFrameMs), por mais eventos de movimento que cheguem nesse meio-tempo.
+    // Dentro de um GeometryBatch (carga, exclusão) só no fim do lote; ao
+    // soltar o mouse, na hora.
+    static constexpr int kFrameMs = 16;
+    void markGeometryDirty(TransitionItem* t);
+    void flushGeometry();
+
+    // Nível de detalhe (pixels por unidade da cena, levelOfDetailFromTransform).
+    // Abaixo de kLodLabels os rótulos somem (setViewScale, pela view principal);
+    // abaixo de kLodArrows as setas perdem a cabeça e o estado final o anel;
+    // abaixo de kLodStraight arestas viram retas sem antialias e self-loops
+    // somem; abaixo de kLodAggregate os itens não se desenham e a cena pinta
+    // a densidade de estados numa grade de kAggregateCellPx.
+    static constexpr qreal kLodLabels    = 0.5;
+    static constexpr qreal kLodArrows    = 0.3;
+    static constexpr qreal kLodStraight  = 0.15;
+    static constexpr qreal kLodAggregate = 0.05;
+    static constexpr qreal kAggregateCellPx = 8.0;
+    void setViewScale(qreal scale);
+    bool labelsShown() const { return labelsShown_; }
+
+    // Limites e índice acompanham o conteúdo: o sceneRect cresce (com folga,
+    // para raramente refazer o índice) quando um estado chega a kSceneMargin
+    // da borda, e a profundidade da BSP segue log2 do número de itens.
+    // Só encolhem em clearDiagram().
+    static constexpr qreal kSceneMargin = 400.0;
+    static constexpr int   kItemsPerLeaf = 8;
+    void growToInclude(const QRectF& r);
+
+    class GeometryBatch {
+    public:
+        explicit GeometryBatch(DiagramScene* s) : s_(s) { if (s_) ++s_->batchDepth_; }
+        ~GeometryBatch() { if (s_ && --s_->batchDepth_ == 0) s_->flushGeometry(); }
+        GeometryBatch(const GeometryBatch&) = delete;
+        GeometryBatch& operator=(const GeometryBatch&) = delete;
+    private:
+        DiagramScene* s_;
+    };
+
+    // Só nome/inicial/final de um estado: o engine atualiza sem reconstruir
+    void notifyStateChanged(StateItem* s) { emit stateChanged(s); }
+    // Só o texto da guarda/ação mudou: basta recompilar aquela transição
+    void notifyScriptChanged(TransitionItem* t) { emit transitionScriptChanged(t); }
+    // Só a prioridade mudou: basta reposicionar na ordem do estado de origem
+    void notifyPriorityChanged(TransitionItem* t) { emit transitionPriorityChanged(t); }
+
+signals:
+    void modelChanged();
+    void stateChanged(StateItem* s);
+    void transitionScriptChanged(TransitionItem* t);
+    // transições entrando/saindo da cena; estados continuam em modelChanged()
+    void transitionAdded(TransitionItem* t);
+    void transitionRemoved(TransitionItem* t);
+    void transitionPriorityChanged(TransitionItem* t);
+
 protected:
     void mousePressEvent(QGraphicsSceneMouseEvent* e) override;
     void mouseMoveEvent(QGraphicsSceneMouseEvent* e) override;
     void mouseReleaseEvent(QGraphicsSceneMouseEvent* e) override;
+    void drawForeground(QPainter* p, const QRectF& rect) override;
 
 private:
+    using BundleKey = QPair<const StateItem*, const StateItem*>;   // (lo, hi) por endereço
     StateItem* stateAt(const QPointF& p) const;
+    void bundleInsert(TransitionItem* t);
+    void bundleErase(TransitionItem* t);
+    static void layoutBundle(const EdgeBundle& b);
+    void adjustIndexDepth();
 
     Mode mode_{Mode::Select};
     QGraphicsLineItem* tempLine_{nullptr};
     StateItem* pendingSrc_{nullptr};
+
+    QVector<StateItem*>      states_;
+    QVector<TransitionItem*> transitions_;
+    QHash<BundleKey, EdgeBundle> bundles_;
+    QHash<const TransitionItem*, BundleKey> bundleOf_;   // o extremo pode já ter sido apagado
+
+    QVector<TransitionItem*> dirty_;   // sem repetição (TransitionItem::pathDirty_)
+    QTimer* frameTimer_{nullptr};
+    int batchDepth_{0};
+    bool labelsShown_{true};
 };
@@ -0,0 +1,115 @@
+#include "DiagramView.h"
+#include "DiagramScene.h"
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QScrollBar>
+#include <QWheelEvent>
+#include <cmath>
+
+DiagramView::DiagramView(QGraphicsScene* scene, QWidget* parent)
+    : QGraphicsView(scene, parent)
+{
+    setTransformationAnchor(QGraphicsView::AnchorUnderMouse);
+    setResizeAnchor(QGraphicsView::AnchorViewCenter);
+}
+
+QRectF DiagramView::visibleSceneRect() const {
+    return mapToScene(viewport()->rect()).boundingRect();
+}
+
+void DiagramView::setZoom(qreal z){
+    z = qBound(kMinZoom, z, kMaxZoom);
+    const qreal f = z / zoom();
+    if (!qFuzzyCompare(f, 1.0)) scale(f, f);
+    zoomChanged();
+}
+
+void DiagramView::zoomChanged(){
+    if (auto ds = qobject_cast<DiagramScene*>(scene())) ds->setViewScale(zoom());
+    emit viewChanged();
+}
+
+void DiagramView::zoomIn()    { setZoom(zoom() * 1.25); }
+void DiagramView::zoomOut()   { setZoom(zoom() / 1.25); }
+void DiagramView::resetZoom() { setZoom(1.0); }
+
+void DiagramView::fitToContent(){
+    if (!scene()) return;
+    QRectF r = scene()->itemsBoundingRect();
+    if (r.isEmpty()) { resetZoom(); return; }
+    r.adjust(-40, -40, 40, 40);
+    fitInView(r, Qt::KeepAspectRatio);
+    setZoom(zoom());   // respeita os limites e atualiza o nível de detalhe
+    centerOn(r.center());
+}
+
+void DiagramView::wheelEvent(QWheelEvent* e){
+    const int dy = e->angleDelta().y();
+    if (dy == 0) { QGraphicsView::wheelEvent(e); return; }
+    setZoom(zoom() * std::pow(1.0015, dy));   // um "clique" (120) ≈ 20%
+    e->accept();
+}
+
+void DiagramView::mousePressEvent(QMouseEvent* e){
+    if (e->button() == Qt::MiddleButton){
+        panning_ = true;
+        panLast_ = e->pos();
+        viewport()->setCursor(Qt::ClosedHandCursor);
+        e->accept();
+        return;
+    }
+    QGraphicsView::mousePressEvent(e);
+}
+
+void DiagramView::mouseMoveEvent(QMouseEvent* e){
+    if (panning_){
+        const QPoint d = e->pos() - panLast_;
+        panLast_ = e->pos();
+        horizontalScrollBar()->setValue(horizontalScrollBar()->value() - d.x());
+        verticalScrollBar()->setValue(verticalScrollBar()->value() - d.y());
+        e->accept();
+        return;
+    }
+    QGraphicsView::mouseMoveEvent(e);
+}
+
+void DiagramView::mouseReleaseEvent(QMouseEvent* e){
+    if (panning_ && e->button() == Qt::MiddleButton){
+        panning_ = false;
+        viewport()->unsetCursor();
+        e->accept();
+        return;
+    }
+    QGraphicsView::mouseReleaseEvent(e);
+}
+
+// Espaço segurado: o botão esquerdo passa a arrastar a vista
+void DiagramView::keyPressEvent(QKeyEvent* e){
+    if (e->key() == Qt::Key_Space && !e->isAutoRepeat()){
+        setDragMode(QGraphicsView::ScrollHandDrag);
+        setInteractive(false);   // não seleciona/move itens enquanto isso
+        e->accept();
+        return;
+    }
+    QGraphicsView::keyPressEvent(e);
+}
+
+void DiagramView::keyReleaseEvent(QKeyEvent* e){
+    if (e->key() == Qt::Key_Space && !e->isAutoRepeat()){
+        setDragMode(QGraphicsView::NoDrag);
+        setInteractive(true);
+        e->accept();
+        return;
+    }
+    QGraphicsView::keyReleaseEvent(e);
+}
+
+void DiagramView::scrollContentsBy(int dx, int dy){
+    QGraphicsView::scrollContentsBy(dx, dy);
+    emit viewChanged();
+}
+
+void DiagramView::resizeEvent(QResizeEvent* e){
+    QGraphicsView::resizeEvent(e);
+    emit viewChanged();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <QGraphicsView>
+
+// View principal do diagrama: zoom pela roda (sob o cursor), arrastar com o
+// botão do meio ou Espaço+esquerdo para deslocar e "Ajustar" ao conteúdo.
+// Informa a escala à DiagramScene (nível de detalhe dos rótulos).
+class DiagramView : public QGraphicsView {
+    Q_OBJECT
+public:
+    explicit DiagramView(QGraphicsScene* scene, QWidget* parent = nullptr);
+
+    static constexpr qreal kMinZoom = 0.01;
+    static constexpr qreal kMaxZoom = 8.0;
+    qreal zoom() const { return transform().m11(); }
+    void setZoom(qreal z);
+
+    QRectF visibleSceneRect() const;
+
+public slots:
+    void zoomIn();
+    void zoomOut();
+    void resetZoom();
+    void fitToContent();
+
+signals:
+    void viewChanged();   // zoom ou rolagem (minimapa)
+
+protected:
+    void wheelEvent(QWheelEvent* e) override;
+    void mousePressEvent(QMouseEvent* e) override;
+    void mouseMoveEvent(QMouseEvent* e) override;
+    void mouseReleaseEvent(QMouseEvent* e) override;
+    void keyPressEvent(QKeyEvent* e) override;
+    void keyReleaseEvent(QKeyEvent* e) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void resizeEvent(QResizeEvent* e) override;
+
+private:
+    void zoomChanged();
+
+    bool panning_ = false;   // botão do meio
+    QPoint panLast_;
+};
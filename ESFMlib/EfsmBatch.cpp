@@ -0,0 +1,145 @@
+#include "EfsmBatch.h"
+#include <QJsonArray>
+#include <QThread>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+QHash<QString, EfsmValue> objectToValues(const QJsonObject& o){
+    QHash<QString, EfsmValue> out;
+    for (auto it = o.begin(); it != o.end(); ++it)
+        out.insert(it.key(), EfsmModel::decodeJsonValue(it.value()));
+    return out;
+}
+
+QHash<QString, int> nameIndex(const QVector<EfsmVar>& vs){
+    QHash<QString, int> out;
+    for (int i=0; i<vs.size(); ++i) out.insert(vs[i].name, i);
+    return out;
+}
+
+struct Names {
+    QHash<QString, int> vars, inputs;
+};
+
+void applyInputs(EfsmEngine& e, const Names& names, const QHash<QString, EfsmValue>& values){
+    for (auto it = values.begin(); it != values.end(); ++it){
+        const int k = names.inputs.value(it.key(), -1);
+        if (k >= 0) e.setInput(k, it.value());
+    }
+}
+
+void runOne(EfsmEngine& e, const Names& names, const EfsmScenario& sc, EfsmScenarioResult& r,
+            const std::atomic<bool>* cancel){
+    r.name = sc.name;
+    // sessão JS nova por cenário: um global deixado por uma ação (var…) não
+    // vaza para o próximo cenário, que pode cair em qualquer worker
+    e.resetSession();
+    e.reset();
+    for (auto it = sc.vars.begin(); it != sc.vars.end(); ++it){
+        const int k = names.vars.value(it.key(), -1);
+        if (k >= 0) e.setVar(k, it.value());
+    }
+    applyInputs(e, names, sc.inputs);
+
+    // roteiro: um passo por linha, enquanto houver linhas
+    r.status = EfsmEngine::StepStatus::Fired;
+    for (int k=0; k<sc.trace.size() && r.steps < sc.maxSteps; ++k){
+        if (cancel && cancel->load(std::memory_order_relaxed)) { r.cancelled = true; break; }
+        if (e.isFinal()) { r.reachedFinal = true; break; }
+        applyInputs(e, names, sc.trace[k]);
+        const EfsmEngine::StepResult s = e.step();
+        r.status = s.status;
+        if (s.status != EfsmEngine::StepStatus::Fired) { r.error = s.error; break; }
+        ++r.steps;
+    }
+
+    // restante com os últimos inputs, no laço apertado do engine
+    if (!r.cancelled && !r.reachedFinal && r.status == EfsmEngine::StepStatus::Fired && r.steps < sc.maxSteps){
+        EfsmEngine::RunLimits lim;
+        lim.maxSteps = sc.maxSteps - r.steps;
+        lim.cancel = cancel;
+        const EfsmEngine::RunResult rr = e.run(lim);
+        r.steps += rr.steps;
+        r.status = rr.status;
+        r.reachedFinal = rr.reachedFinal;
+        r.error = rr.error;
+        // o run devolve Fired também ao parar pelo cancel
+        r.cancelled = cancel && cancel->load(std::memory_order_relaxed)
+                   && rr.status == EfsmEngine::StepStatus::Fired && !rr.reachedFinal && r.steps < sc.maxSteps;
+    } else if (!r.reachedFinal) {
+        r.reachedFinal = e.isFinal();
+    }
+
+    r.finalState = e.currentState();
+    r.vars = e.vars();
+    r.outputs = e.outputs();
+}
+
+} // namespace
+
+EfsmScenario EfsmScenario::fromJson(const QJsonObject& o){
+    EfsmScenario sc;
+    sc.name     = o.value("name").toString();
+    sc.vars     = objectToValues(o.value("vars").toObject());
+    sc.inputs   = objectToValues(o.value("inputs").toObject());
+    sc.maxSteps = (qint64)o.value("maxSteps").toDouble(10000);
+    for (const auto& row : o.value("trace").toArray())
+        sc.trace.push_back(objectToValues(row.toObject()));
+    return sc;
+}
+
+bool EfsmBatch::scenariosFromJson(const QJsonValue& root, QVector<EfsmScenario>& out, QString* error){
+    out.clear();
+    const QJsonValue arr = root.isObject() ? root.toObject().value("scenarios") : root;
+    if (!arr.isArray()){
+        if (error) *error = "Chave \"scenarios\" ausente ou inválida.";
+        return false;
+    }
+    for (const auto& v : arr.toArray()){
+        EfsmScenario sc = EfsmScenario::fromJson(v.toObject());
+        if (sc.name.isEmpty()) sc.name = QString("#%1").arg(out.size()+1);
+        out.push_back(sc);
+    }
+    return true;
+}
+
+QVector<EfsmScenarioResult> EfsmBatch::run(const EfsmModel& model,
+                                           const QVector<EfsmScenario>& scenarios,
+                                           int threads,
+                                           const ProgressFn& progress,
+                                           const std::atomic<bool>* cancel){
+    QVector<EfsmScenarioResult> results(scenarios.size());
+    if (scenarios.isEmpty()) return results;
+    if (threads <= 0) threads = QThread::idealThreadCount();
+    threads = qBound(1, threads, scenarios.size());
+
+    const Names names{ nameIndex(model.vars), nameIndex(model.inputs) };
+
+    // cada worker pega o próximo cenário livre (sem partição fixa: cenários
+    // longos não deixam os outros núcleos ociosos)
+    std::atomic<int> next{0}, finished{0};
+    EfsmScenarioResult* out = results.data();   // destaca antes de abrir as threads
+    auto worker = [&](){
+        EfsmEngine engine(model);   // sessão JS própria, criada nesta thread
+        for (int i = next.fetch_add(1); i < scenarios.size(); i = next.fetch_add(1)){
+            if (cancel && cancel->load(std::memory_order_relaxed)){
+                out[i].name = scenarios[i].name;
+                out[i].cancelled = true;
+                continue;
+            }
+            runOne(engine, names, scenarios[i], out[i], cancel);
+            const int n = finished.fetch_add(1) + 1;
+            if (progress) progress(n, scenarios.size());
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads-1);
+    for (int t=1; t<threads; ++t) pool.emplace_back(worker);
+    worker();   // a thread chamadora também trabalha
+    for (auto& th : pool) th.join();
+    return results;
+}
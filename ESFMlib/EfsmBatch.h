@@ -0,0 +1,57 @@
+#pragma once
+#include "EfsmEngine.h"
+#include <QHash>
+#include <QJsonObject>
+#include <atomic>
+#include <functional>
+
+// Simulação em lote: muitas instâncias independentes do mesmo modelo.
+// O EfsmModel é compartilhado (só leitura, implicitamente compartilhado
+// pelo Qt); cada thread tem o próprio EfsmEngine e, portanto, o próprio
+// QJSEngine — nada é travado entre instâncias. Cada cenário começa numa
+// sessão JS nova, então o resultado não depende de quantas threads rodam
+// nem de qual delas pegou o cenário.
+
+struct EfsmScenario {
+    QString name;
+    QHash<QString, EfsmValue> vars;    // sobrescreve os valores iniciais de X
+    QHash<QString, EfsmValue> inputs;  // idem para I
+    // roteiro de inputs: antes do passo k aplica trace[k] (o último vale
+    // para os passos seguintes)
+    QVector<QHash<QString, EfsmValue>> trace;
+    qint64 maxSteps = 10000;
+
+    // {"name","vars":{…},"inputs":{…},"trace":[{…},…],"maxSteps"}
+    static EfsmScenario fromJson(const QJsonObject& o);
+};
+
+struct EfsmScenarioResult {
+    QString name;
+    int finalState = -1;               // índice em model.states
+    qint64 steps = 0;
+    EfsmEngine::StepStatus status = EfsmEngine::StepStatus::NoCurrentState; // Fired = limite de passos
+    bool reachedFinal = false;
+    QString error;                     // ActionError
+    bool cancelled = false;            // interrompido (ou nem iniciado) pelo cancel
+    QVector<EfsmValue> vars;           // valuations finais, na ordem de model.vars
+    QVector<EfsmValue> outputs;
+};
+
+class EfsmBatch {
+public:
+    // chamado por qualquer worker ao concluir um cenário (done de total)
+    using ProgressFn = std::function<void(int done, int total)>;
+
+    // threads <= 0: QThread::idealThreadCount(). Resultados na ordem dos cenários.
+    // cancel é conferido a cada passo; os cenários interrompidos ou não
+    // iniciados voltam com cancelled = true.
+    static QVector<EfsmScenarioResult> run(const EfsmModel& model,
+                                           const QVector<EfsmScenario>& scenarios,
+                                           int threads = 0,
+                                           const ProgressFn& progress = ProgressFn(),
+                                           const std::atomic<bool>* cancel = nullptr);
+
+    // {"scenarios":[…]} ou diretamente um array de cenários
+    static bool scenariosFromJson(const QJsonValue& root, QVector<EfsmScenario>& out,
+                                  QString* error = nullptr);
+};
@@ -0,0 +1,233 @@
+// efsm_bench: vazão do núcleo sobre modelos sintéticos, para comparar
+// commits/versões do Qt. Um objeto JSON por execução na saída padrão.
+//
+//   efsm_bench                                   // 1000 estados × 4
+//   efsm_bench --states 10000 --fanout 10        // 100k transições
+//   efsm_bench --js-ratio 0.2 --label "$(git rev-parse --short HEAD)"
+//
+// Modelo: estados S0…Sn-1 (S0 inicial, nenhum final), fanout transições por
+// estado, das quais self-loops saem para o próprio estado. Guardas com
+// guard-terms comparações "x % m != r" ligadas por && / ||; a última
+// transição de cada estado tem guarda "true", então sempre há uma habilitada.
+// Ações "x := (x + k) % 1000" mantêm os inteiros pequenos (caminho do VM).
+// js-ratio das guardas chama Math.abs e, portanto, roda no QJSEngine.
+#include "EfsmEngine.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <cstdio>
+#include <random>
+#ifdef Q_OS_WIN
+#  include <windows.h>
+#  include <psapi.h>
+#else
+#  include <sys/resource.h>
+#endif
+
+namespace {
+
+struct Params {
+    int states = 1000;
+    int fanout = 4;
+    double selfLoops = 0.1;
+    int vars = 8;
+    int inputs = 4;
+    int guardTerms = 2;
+    double jsRatio = 0.0;
+    qint64 steps = 1000000;
+    quint64 seed = 1;
+};
+
+// pico de memória residente do processo, em KiB
+qint64 peakRssKb(){
+#ifdef Q_OS_WIN
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return qint64(pmc.PeakWorkingSetSize / 1024);
+    return -1;
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+#  ifdef Q_OS_MACOS
+    return qint64(ru.ru_maxrss / 1024);   // bytes no macOS
+#  else
+    return qint64(ru.ru_maxrss);          // KiB no Linux
+#  endif
+#endif
+}
+
+EfsmModel synthesize(const Params& p){
+    std::mt19937_64 rng(p.seed);
+    auto below = [&rng](int n){ return int(rng() % quint64(qMax(1, n))); };
+    auto chance = [&rng](double f){ return double(rng() >> 11) * (1.0 / 9007199254740992.0) < f; };
+
+    EfsmModel m;
+    for (int k=0; k<p.vars; ++k)   m.vars.push_back({ QString("x%1").arg(k), EfsmValue::fromInt(0) });
+    for (int k=0; k<p.inputs; ++k) m.inputs.push_back({ QString("i%1").arg(k), EfsmValue::fromInt(below(100)) });
+    m.outputs.push_back({ "o0", EfsmValue::fromInt(0) });
+
+    m.states.reserve(p.states);
+    for (int s=0; s<p.states; ++s){
+        EfsmState st;
+        st.name = QString("S%1").arg(s);
+        st.x = (s % 100) * 120.0;
+        st.y = (s / 100) * 120.0;
+        st.initial = s == 0;
+        m.states.push_back(st);
+    }
+
+    // operando de uma comparação: variável ou input
+    auto operand = [&](){
+        return p.inputs > 0 && chance(0.25) ? QString("i%1").arg(below(p.inputs))
+                                            : QString("x%1").arg(below(p.vars));
+    };
+    m.transitions.reserve(qint64(p.states) * p.fanout);
+    int id = 0;
+    for (int s=0; s<p.states; ++s){
+        for (int f=0; f<p.fanout; ++f){
+            EfsmTransition t;
+            t.id = ++id;
+            t.from = s;
+            t.to = chance(p.selfLoops) ? s : below(p.states);
+            const bool last = f == p.fanout - 1;
+            t.priority = last ? 100 : below(4);   // a última é a reserva
+            if (last || p.vars == 0){
+                t.guard = "true";
+            } else {
+                QStringList terms;
+                for (int k=0; k<p.guardTerms; ++k){
+                    const int mod = 2 + below(9);
+                    QString lhs = operand();
+                    if (chance(p.jsRatio) && k == 0) lhs = "Math.abs(" + lhs + ")";   // força o JS
+                    terms << QString("%1 %% %2 != %3").arg(lhs).arg(mod).arg(below(mod));
+                }
+                QString g = terms.front();
+                for (int k=1; k<terms.size(); ++k) g += (below(3) == 0 ? " || " : " && ") + terms[k];
+                t.guard = g;
+            }
+            if (p.vars > 0){
+                const int a = below(p.vars);
+                t.action = QString("x%1 := (x%1 + %2) %% 1000").arg(a).arg(1 + below(97));
+                if (chance(0.1)) t.action += QString("; o0 := x%1").arg(a);
+            }
+            m.transitions.push_back(t);
+        }
+    }
+    m.rebuildIndex();
+    return m;
+}
+
+double perSecond(qint64 n, qint64 ns){ return ns > 0 ? double(n) * 1e9 / double(ns) : 0.0; }
+
+} // namespace
+
+int main(int argc, char** argv){
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("efsm_bench");
+
+    QCommandLineParser cl;
+    cl.setApplicationDescription("Benchmark do núcleo EFSM sobre modelos sintéticos (saída JSON).");
+    cl.addHelpOption();
+    const QCommandLineOption statesOpt("states", "Número de estados.", "N", "1000");
+    const QCommandLineOption fanoutOpt("fanout", "Transições saindo de cada estado.", "N", "4");
+    const QCommandLineOption selfOpt("self-loops", "Fração de self-loops (0..1).", "f", "0.1");
+    const QCommandLineOption varsOpt("vars", "Variáveis inteiras em X.", "N", "8");
+    const QCommandLineOption inputsOpt("inputs", "Inputs inteiros em I.", "N", "4");
+    const QCommandLineOption termsOpt("guard-terms", "Comparações por guarda.", "N", "2");
+    const QCommandLineOption jsOpt("js-ratio", "Fração das guardas que exigem o JS (0..1).", "f", "0");
+    const QCommandLineOption stepsOpt("steps", "Passos medidos.", "N", "1000000");
+    const QCommandLineOption seedOpt("seed", "Semente do gerador.", "N", "1");
+    const QCommandLineOption labelOpt("label", "Rótulo livre no resultado (ex.: commit).", "texto");
+    cl.addOptions({ statesOpt, fanoutOpt, selfOpt, varsOpt, inputsOpt, termsOpt, jsOpt, stepsOpt, seedOpt, labelOpt });
+    cl.process(app);
+
+    Params p;
+    p.states     = qMax(1, cl.value(statesOpt).toInt());
+    p.fanout     = qMax(1, cl.value(fanoutOpt).toInt());
+    p.selfLoops  = qBound(0.0, cl.value(selfOpt).toDouble(), 1.0);
+    p.vars       = qMax(0, cl.value(varsOpt).toInt());
+    p.inputs     = qMax(0, cl.value(inputsOpt).toInt());
+    p.guardTerms = qMax(1, cl.value(termsOpt).toInt());
+    p.jsRatio    = qBound(0.0, cl.value(jsOpt).toDouble(), 1.0);
+    p.steps      = qMax<qint64>(1, cl.value(stepsOpt).toLongLong());
+    p.seed       = cl.value(seedOpt).toULongLong();
+
+    QElapsedTimer clock;
+    QJsonObject res;
+    if (cl.isSet(labelOpt)) res["label"] = cl.value(labelOpt);
+    res["qt"] = QString(qVersion());
+    res["os"] = QSysInfo::prettyProductName();
+    res["cpu"] = QSysInfo::currentCpuArchitecture();
+
+    QJsonObject params;
+    params["states"] = p.states;
+    params["fanout"] = p.fanout;
+    params["transitions"] = double(qint64(p.states) * p.fanout);
+    params["selfLoops"] = p.selfLoops;
+    params["vars"] = p.vars;
+    params["inputs"] = p.inputs;
+    params["guardTerms"] = p.guardTerms;
+    params["jsRatio"] = p.jsRatio;
+    params["steps"] = double(p.steps);
+    params["seed"] = double(p.seed);
+    res["params"] = params;
+
+    // geração, gravação e leitura (o mesmo JSON do "Salvar…")
+    clock.start();
+    const EfsmModel generated = synthesize(p);
+    const qint64 genNs = clock.nsecsElapsed();
+
+    clock.restart();
+    const QByteArray json = QJsonDocument(generated.toJson()).toJson(QJsonDocument::Compact);
+    const qint64 saveNs = clock.nsecsElapsed();
+
+    clock.restart();
+    EfsmModel model;
+    QString err;
+    if (!model.fromJson(QJsonDocument::fromJson(json).object(), &err)){
+        std::fprintf(stderr, "efsm_bench: modelo gerado não recarrega: %s\n", qPrintable(err));
+        return 1;
+    }
+    const qint64 loadNs = clock.nsecsElapsed();
+
+    clock.restart();
+    EfsmEngine engine(model);
+    const qint64 setupNs = clock.nsecsElapsed();
+
+    // aquecimento: compila os scripts das transições mais alcançadas
+    EfsmEngine::RunLimits warm;
+    warm.maxSteps = qMin<qint64>(p.steps / 10, 10000);
+    warm.stopAtFinal = false;
+    engine.run(warm);
+    engine.resetGuardStats();
+
+    EfsmEngine::RunLimits lim;
+    lim.maxSteps = p.steps;
+    lim.stopAtFinal = false;
+    clock.restart();
+    const EfsmEngine::RunResult r = engine.run(lim);
+    const qint64 runNs = clock.nsecsElapsed();
+    const auto& gs = engine.guardStats();
+
+    QJsonObject m;
+    m["generateMs"] = genNs / 1e6;
+    m["saveMs"] = saveNs / 1e6;
+    m["loadMs"] = loadNs / 1e6;
+    m["jsonBytes"] = double(json.size());
+    m["engineSetupMs"] = setupNs / 1e6;
+    m["runMs"] = runNs / 1e6;
+    m["steps"] = double(r.steps);
+    m["stepsPerSec"] = perSecond(r.steps, runNs);
+    m["guardEvalsPerSec"] = perSecond(gs.evaluated + gs.cached, runNs);   // inclui as do memo
+    m["guardsEvaluated"] = double(gs.evaluated);
+    m["guardsCached"] = double(gs.cached);
+    m["peakRssKb"] = double(peakRssKb());
+    if (r.status != EfsmEngine::StepStatus::Fired) m["stoppedEarly"] = r.error.isEmpty() ? QString("sem transição") : r.error;
+    res["metrics"] = m;
+
+    std::fputs(QJsonDocument(res).toJson(QJsonDocument::Compact).constData(), stdout);
+    std::fputc('\n', stdout);
+    return 0;
+}
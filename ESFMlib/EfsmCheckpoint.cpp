@@ -0,0 +1,207 @@
+#include "EfsmCheckpoint.h"
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+namespace {
+
+constexpr quint32 kMagic = 0x4546434b;   // "EFCK"
+constexpr quint16 kVersion = 1;
+// menor registro X|I|O: nome vazio (quint32) + tipo (quint8) + valor (qint64
+// ou string vazia, quint32)
+constexpr qint64 kMinEntryBytes = 4 + 1 + 4;
+
+} // namespace
+
+EfsmCheckpoint EfsmCheckpoint::capture(const EfsmEngine& e){
+    const EfsmModel& m = e.model();
+    EfsmCheckpoint cp;
+    cp.stateCount = m.states.size();
+    cp.state = e.currentState();
+    if (cp.state >= 0 && cp.state < m.states.size()) cp.stateName = m.states[cp.state].name;
+    cp.steps = e.stepCount();
+    cp.nx = m.vars.size();
+    cp.ni = m.inputs.size();
+    cp.no = m.outputs.size();
+    cp.names.reserve(cp.nx + cp.ni + cp.no);
+    for (const QVector<EfsmVar>* decl : { &m.vars, &m.inputs, &m.outputs })
+        for (const auto& v : *decl) cp.names.push_back(v.name);
+    cp.values = e.values();   // compartilhado até o próximo passo escrever
+    return cp;
+}
+
+bool EfsmCheckpoint::apply(EfsmEngine& e, QString* error) const {
+    const EfsmModel& m = e.model();
+    bool same = m.states.size() == stateCount && m.vars.size() == nx
+             && m.inputs.size() == ni && m.outputs.size() == no;
+    for (int k=0; same && k<names.size(); ++k){
+        const EfsmVar& v = k < nx ? m.vars[k] : k < nx + ni ? m.inputs[k - nx] : m.outputs[k - nx - ni];
+        same = v.name == names[k];
+    }
+    same = same && names.size() == nx + ni + no && values.size() == names.size()
+                && state >= -1 && state < m.states.size();
+    if (!same || (state >= 0 && m.states[state].name != stateName)){
+        if (error) *error = "O checkpoint é de outro modelo (estados ou X/I/O diferentes).";
+        return false;
+    }
+
+    e.setCurrentState(state);
+    e.setStepCount(steps);
+    for (int k=0; k<nx; ++k) e.setVar(k, values[k]);
+    for (int k=0; k<ni; ++k) e.setInput(k, values[nx + k]);
+    for (int k=0; k<no; ++k) e.setOutput(k, values[nx + ni + k]);
+    return true;
+}
+
+QByteArray EfsmCheckpoint::toBinary() const {
+    QByteArray data;
+    data.reserve(64 + values.size() * 24);
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << kMagic << kVersion
+        << qint32(stateCount) << qint32(state) << stateName << steps
+        << qint32(nx) << qint32(ni) << qint32(no);
+    for (int k=0; k<values.size(); ++k){
+        const EfsmValue& v = values[k];
+        out << names[k] << quint8(v.type);
+        if (v.type == EfsmValue::String) out << v.s;
+        else                             out << v.i;
+    }
+    return data;
+}
+
+bool EfsmCheckpoint::fromBinary(const QByteArray& data, EfsmCheckpoint& out, QString* error,
+                                const EfsmModel* model){
+    QDataStream in(data);
+    in.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != kMagic || version != kVersion){
+        if (error) *error = "Arquivo não é um checkpoint (ou é de versão desconhecida).";
+        return false;
+    }
+    auto corrupt = [error](const QString& why){
+        if (error) *error = "Checkpoint corrompido: " + why + ".";
+        return false;
+    };
+    EfsmCheckpoint cp;
+    qint32 stateCount = 0, state = -1, nx = 0, ni = 0, no = 0;
+    in >> stateCount >> state >> cp.stateName >> cp.steps >> nx >> ni >> no;
+    if (in.status() != QDataStream::Ok){
+        if (error) *error = "Checkpoint truncado.";
+        return false;
+    }
+    if (stateCount < 0 || state < -1 || state >= stateCount) return corrupt("estado fora do intervalo");
+    if (cp.steps < 0) return corrupt("contador de passos negativo");
+    if (nx < 0 || ni < 0 || no < 0) return corrupt("contagem de X/I/O negativa");
+    if (model && (stateCount != model->states.size() || nx != model->vars.size()
+                  || ni != model->inputs.size() || no != model->outputs.size())){
+        if (error) *error = "O checkpoint é de outro modelo (estados ou X/I/O diferentes).";
+        return false;
+    }
+    // soma em 64 bits e limitada pelo que resta do arquivo: nada de alocar
+    // por uma contagem que os bytes não comportam
+    const qint64 n = qint64(nx) + ni + no;
+    const qint64 left = data.size() - in.device()->pos();
+    if (n > left / kMinEntryBytes) return corrupt("contagem de X/I/O maior que o arquivo");
+
+    cp.stateCount = stateCount; cp.state = state;
+    cp.nx = nx; cp.ni = ni; cp.no = no;
+    cp.names.resize(int(n));
+    cp.values.resize(int(n));
+    for (int k=0; k<n && in.status() == QDataStream::Ok; ++k){
+        quint8 type = 0;
+        in >> cp.names[k] >> type;
+        if (type > EfsmValue::String) return corrupt(QString("tipo %1 desconhecido").arg(type));
+        EfsmValue& v = cp.values[k];
+        v.type = EfsmValue::Type(type);
+        if (v.type == EfsmValue::String) in >> v.s;
+        else                             in >> v.i;
+        if (v.type == EfsmValue::Bool && v.i != 0 && v.i != 1) return corrupt("booleano fora de 0/1");
+    }
+    if (in.status() != QDataStream::Ok){
+        if (error) *error = "Checkpoint truncado.";
+        return false;
+    }
+    out = cp;
+    return true;
+}
+
+bool EfsmCheckpoint::save(const EfsmCheckpoint& cp, const QString& path, QString* error){
+    // QSaveFile: grava ao lado e troca no commit(), então uma queda no meio
+    // da gravação deixa o checkpoint anterior intacto
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) { if (error) *error = f.errorString(); return false; }
+    const QByteArray data = cp.toBinary();
+    if (f.write(data) != data.size() || !f.commit()){
+        if (error) *error = f.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool EfsmCheckpoint::load(const QString& path, EfsmCheckpoint& out, QString* error,
+                          const EfsmModel* model){
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) { if (error) *error = f.errorString(); return false; }
+    return fromBinary(f.readAll(), out, error, model);
+}
+
+// ===== gravação em segundo plano =====
+
+EfsmCheckpointWriter::EfsmCheckpointWriter()
+    : thread_([this](){ loop(); }) {}
+
+EfsmCheckpointWriter::~EfsmCheckpointWriter(){
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void EfsmCheckpointWriter::submit(const EfsmCheckpoint& cp, const QString& path){
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        if (hasPending_) ++stats_.replaced;
+        pending_ = cp;
+        path_ = path;
+        hasPending_ = true;
+    }
+    cv_.notify_one();
+}
+
+EfsmCheckpointWriter::Stats EfsmCheckpointWriter::stats() const {
+    std::lock_guard<std::mutex> lock(m_);
+    return stats_;
+}
+
+void EfsmCheckpointWriter::loop(){
+    for (;;){
+        EfsmCheckpoint cp;
+        QString path;
+        {
+            std::unique_lock<std::mutex> lock(m_);
+            cv_.wait(lock, [this]{ return hasPending_ || stop_; });
+            if (!hasPending_) return;   // stop_ sem nada pendente
+            cp = std::move(pending_);
+            path = path_;
+            hasPending_ = false;
+        }
+
+        QElapsedTimer clock;
+        clock.start();
+        QString err;
+        const bool ok = EfsmCheckpoint::save(cp, path, &err);
+
+        std::lock_guard<std::mutex> lock(m_);
+        if (ok) { ++stats_.written; stats_.lastError.clear(); }
+        else    stats_.lastError = err;
+        stats_.lastBytes = ok ? QFileInfo(path).size() : 0;
+        stats_.lastMs = clock.elapsed();
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "EfsmEngine.h"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Estado de execução de um EfsmEngine (estado corrente, X|I|O, contador de
+// passos) num formato binário compacto, para retomar uma simulação longa.
+// O modelo em si continua no JSON do "Salvar…": o checkpoint só confere que
+// a estrutura é a mesma (número de estados, nomes e ordem de X/I/O).
+//
+// capture() é O(1) no laço de passos (os slots são compartilhados por
+// cópia na escrita); serializar e gravar fica para EfsmCheckpointWriter.
+struct EfsmCheckpoint {
+    int stateCount = 0;
+    int state = -1;
+    QString stateName;
+    qint64 steps = 0;            // = cursor do histórico no momento da captura
+    int nx = 0, ni = 0, no = 0;
+    QVector<QString> names;      // X | I | O
+    QVector<EfsmValue> values;
+
+    static EfsmCheckpoint capture(const EfsmEngine& e);
+    bool apply(EfsmEngine& e, QString* error = nullptr) const;
+
+    // fromBinary recusa entrada corrompida (contagens negativas ou além do
+    // que os bytes restantes comportam, estado fora de [-1, stateCount),
+    // tipo desconhecido) em vez de devolver um checkpoint inválido. Com
+    // model, as contagens são conferidas contra ele antes de alocar.
+    QByteArray toBinary() const;
+    static bool fromBinary(const QByteArray& data, EfsmCheckpoint& out, QString* error = nullptr,
+                           const EfsmModel* model = nullptr);
+
+    static bool save(const EfsmCheckpoint& cp, const QString& path, QString* error = nullptr);
+    static bool load(const QString& path, EfsmCheckpoint& out, QString* error = nullptr,
+                     const EfsmModel* model = nullptr);
+};
+
+// Grava checkpoints numa thread própria: submit() só entrega a captura e
+// volta. Se uma gravação ainda está em curso, a captura pendente é trocada
+// pela mais nova (só a última importa).
+class EfsmCheckpointWriter {
+public:
+    struct Stats {
+        qint64 written = 0;
+        qint64 replaced = 0;     // capturas descartadas por outra mais nova
+        qint64 lastBytes = 0;
+        qint64 lastMs = 0;
+        QString lastError;
+    };
+
+    EfsmCheckpointWriter();
+    ~EfsmCheckpointWriter();   // grava o pendente e encerra a thread
+
+    void submit(const EfsmCheckpoint& cp, const QString& path);
+    Stats stats() const;
+
+private:
+    void loop();
+
+    mutable std::mutex m_;
+    std::condition_variable cv_;
+    bool hasPending_ = false;
+    bool stop_ = false;
+    EfsmCheckpoint pending_;
+    QString path_;
+    Stats stats_;
+    std::thread thread_;
+};
@@ -0,0 +1,450 @@
+#include "EfsmCodegen.h"
+#include "EfsmVm.h"
+#include <QHash>
+#include <QSet>
+
+namespace {
+
+const QSet<QString>& cppKeywords(){
+    static const QSet<QString> kw = {
+        "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break",
+        "case", "catch", "char", "char8_t", "char16_t", "char32_t", "class", "compl", "concept",
+        "const", "consteval", "constexpr", "constinit", "const_cast", "continue", "co_await",
+        "co_return", "co_yield", "decltype", "default", "delete", "do", "double", "dynamic_cast",
+        "else", "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto",
+        "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+        "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register",
+        "reinterpret_cast", "requires", "return", "short", "signed", "sizeof", "static",
+        "static_assert", "static_cast", "struct", "switch", "template", "this", "thread_local",
+        "throw", "true", "try", "typedef", "typeid", "typename", "union", "unsigned", "using",
+        "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq", "int64_t"
+    };
+    return kw;
+}
+
+// nome do modelo -> identificador C++ válido e único em used
+QString identifier(const QString& name, QSet<QString>& used){
+    QString id;
+    for (const QChar c : name)
+        id += (c.isLetterOrNumber() && c.unicode() < 128) || c == '_' ? c : QChar('_');
+    if (id.isEmpty() || id[0].isDigit() || id.startsWith('_')) id.prepend("v");
+    if (cppKeywords().contains(id)) id += '_';
+    QString unique = id;
+    for (int n = 2; used.contains(unique); ++n) unique = id + QString("_%1").arg(n);
+    used.insert(unique);
+    return unique;
+}
+
+QString cppString(const QString& s){
+    QString out = "\"";
+    for (const QChar c : s){
+        if (c == '"' || c == '\\') out += '\\';
+        if (c == '\n') { out += "\\n"; continue; }
+        out += c;
+    }
+    return out + '"';
+}
+
+// texto de guarda/ação/estado para um comentário "//" de uma linha (uma
+// barra invertida no fim continuaria o comentário na linha seguinte)
+QString oneLine(const QString& s){
+    QString t = s.simplified();
+    if (t.endsWith('\\')) t += '`';
+    return t;
+}
+
+QString cppType(EfsmValue::Type t){
+    switch (t){
+    case EfsmValue::Bool: return "bool";
+    case EfsmValue::Int:  return "int64_t";
+    default:              return "std::string";
+    }
+}
+
+QString cppValue(const EfsmValue& v){
+    switch (v.type){
+    case EfsmValue::Bool: return v.i ? "true" : "false";
+    case EfsmValue::Int:  return QString("int64_t(%1)").arg(v.i);
+    default:              return "std::string(" + cppString(v.s) + ")";
+    }
+}
+
+struct Slot {
+    QString name;
+    QString path;     // m.x.campo
+    EfsmValue::Type type = EfsmValue::Int;
+    bool input = false;
+};
+
+// expressão C++ com o tipo JS que ela teria; Mixed = && / || entre bool e
+// int, só usável como valor-verdade (o código já é o bool correspondente)
+struct Expr {
+    enum Type { Bool, Int, Mixed };
+    QString code;
+    Type type = Int;
+};
+
+// Bytecode do EfsmVm -> C++. O compilador do VM gera código estruturado
+// (os saltos de && e || só pulam o operando da direita), então basta
+// simular a pilha com expressões no lugar de valores.
+class Translator {
+public:
+    Translator(const QVector<Slot>& slots, const QHash<QString, int>& slotOf, int nx, int ni)
+        : slots_(slots), resolve_([&slotOf, nx, ni](const QString& name, bool forWrite){
+              const int slot = slotOf.value(name, -1);
+              if (forWrite && slot >= nx && slot < nx + ni) return -1;   // ações não escrevem inputs
+              return slot;
+          }) {}
+
+    bool guard(const QString& text, QString& code, QString& why){
+        QString src = text.trimmed();
+        while (src.endsWith(';')) src.chop(1);
+        if (src.trimmed().isEmpty()) { code = "true"; return true; }
+        EfsmVm::Program p;
+        if (!EfsmVm::compileGuard(src, resolve_, p)) { why = "guarda fora do subconjunto bool/int"; return false; }
+        locals_.clear();
+        stmts_ = nullptr;
+        QVector<Expr> st;
+        if (!walk(p, 0, p.code.size(), st, why)) return false;
+        if (st.size() != 1) { why = "guarda malformada"; return false; }
+        code = truth(st[0]);
+        return true;
+    }
+
+    // decls: locais com os valores atuais; stmts: o corpo; commits: escrita
+    // de volta (só depois de conferir ok)
+    bool action(const QString& text, QStringList& decls, QStringList& stmts, QStringList& commits, QString& why){
+        QString src = text.trimmed();
+        src.replace(":=", "=");
+        while (src.endsWith(';')) src.chop(1);
+        if (src.isEmpty()) return true;
+        EfsmVm::Program p;
+        if (!EfsmVm::compileAction(src, resolve_, p)) { why = "ação fora do subconjunto bool/int/:="; return false; }
+        locals_.clear();
+        for (int k=0; k<p.writes.size(); ++k){
+            const Slot& s = slots_[p.writes[k]];
+            if (s.type == EfsmValue::String) { why = "ação escreve a string " + s.name; return false; }
+            const QString local = QString("w%1").arg(k);
+            locals_.insert(p.writes[k], local);
+            decls << QString("%1 %2 = %3;").arg(cppType(s.type), local, s.path);
+            commits << QString("%1 = %2;").arg(s.path, local);
+        }
+        stmts_ = &stmts;
+        QVector<Expr> st;
+        const bool ok = walk(p, 0, p.code.size(), st, why);
+        stmts_ = nullptr;
+        return ok;
+    }
+
+private:
+    static QString asInt(const Expr& e){ return e.type == Expr::Bool ? "int64_t(" + e.code + ")" : e.code; }
+    static QString truth(const Expr& e){ return e.type == Expr::Int ? "(" + e.code + " != 0)" : e.code; }
+
+    bool walk(const EfsmVm::Program& p, int pc, int end, QVector<Expr>& st, QString& why){
+        while (pc < end){
+            const EfsmVm::Instr in = p.code[pc];
+            switch (in.op){
+            case EfsmVm::PushConst: {
+                const EfsmValue& v = p.consts[in.arg];
+                if (v.type == EfsmValue::Bool) st.push_back({ v.i ? "true" : "false", Expr::Bool });
+                else                           st.push_back({ QString("int64_t(%1)").arg(v.i), Expr::Int });
+                break;
+            }
+            case EfsmVm::Load: {
+                const Slot& s = slots_[in.arg];
+                if (s.type == EfsmValue::String) { why = "lê a string " + s.name; return false; }
+                const auto it = locals_.constFind(in.arg);
+                QString code = it != locals_.constEnd() ? it.value() : s.path;
+                // inputs vêm de fora: fora de ±2^53 o VM cairia para o JS
+                if (s.input && s.type == EfsmValue::Int) code = "rt::safe(" + code + ", ok)";
+                st.push_back({ code, s.type == EfsmValue::Bool ? Expr::Bool : Expr::Int });
+                break;
+            }
+            case EfsmVm::Store: {
+                const Expr e = st.takeLast();
+                const Slot& s = slots_[in.arg];
+                if (e.type == Expr::Mixed || (e.type == Expr::Bool) != (s.type == EfsmValue::Bool)){
+                    why = QString("%1 (%2) mudaria de tipo").arg(s.name, cppType(s.type));
+                    return false;
+                }
+                if (!stmts_) { why = "atribuição numa guarda"; return false; }
+                *stmts_ << QString("%1 = %2;").arg(locals_.value(in.arg), e.code);
+                break;
+            }
+            case EfsmVm::Not: {
+                const Expr e = st.takeLast();
+                st.push_back({ "!" + truth(e), Expr::Bool });
+                break;
+            }
+            case EfsmVm::Neg: case EfsmVm::Plus: {
+                const Expr e = st.takeLast();
+                if (e.type == Expr::Mixed) { why = "&&/|| entre bool e int usado como número"; return false; }
+                st.push_back({ in.op == EfsmVm::Neg ? "(-" + asInt(e) + ")" : asInt(e), Expr::Int });
+                break;
+            }
+            case EfsmVm::Add: case EfsmVm::Sub: case EfsmVm::Mul: case EfsmVm::Mod: {
+                const Expr b = st.takeLast(), a = st.takeLast();
+                if (a.type == Expr::Mixed || b.type == Expr::Mixed) { why = "&&/|| entre bool e int usado como número"; return false; }
+                const char* fn = in.op == EfsmVm::Add ? "add" : in.op == EfsmVm::Sub ? "sub"
+                               : in.op == EfsmVm::Mul ? "mul" : "mod";
+                st.push_back({ QString("rt::%1(%2, %3, ok)").arg(fn, asInt(a), asInt(b)), Expr::Int });
+                break;
+            }
+            case EfsmVm::Lt: case EfsmVm::Le: case EfsmVm::Gt: case EfsmVm::Ge:
+            case EfsmVm::Eq: case EfsmVm::Ne: {
+                const Expr b = st.takeLast(), a = st.takeLast();
+                if (a.type == Expr::Mixed || b.type == Expr::Mixed) { why = "&&/|| entre bool e int comparado"; return false; }
+                const char* op = in.op == EfsmVm::Lt ? "<" : in.op == EfsmVm::Le ? "<=" : in.op == EfsmVm::Gt ? ">"
+                               : in.op == EfsmVm::Ge ? ">=" : in.op == EfsmVm::Eq ? "==" : "!=";
+                st.push_back({ QString("(%1 %2 %3)").arg(asInt(a), op, asInt(b)), Expr::Bool });
+                break;
+            }
+            case EfsmVm::StrictEq: case EfsmVm::StrictNe: {
+                const Expr b = st.takeLast(), a = st.takeLast();
+                if (a.type == Expr::Mixed || b.type == Expr::Mixed) { why = "&&/|| entre bool e int comparado"; return false; }
+                const bool eq = in.op == EfsmVm::StrictEq;
+                if (a.type != b.type)   // 1 === true é falso no JS; os operandos ainda são avaliados
+                    st.push_back({ QString("((void)%1, (void)%2, %3)").arg(a.code, b.code, eq ? "false" : "true"), Expr::Bool });
+                else
+                    st.push_back({ QString("(%1 %2 %3)").arg(a.code, eq ? "==" : "!=", b.code), Expr::Bool });
+                break;
+            }
+            case EfsmVm::JumpIfFalseKeep: case EfsmVm::JumpIfTrueKeep: {
+                // [esquerda] J [direita] <- alvo: && / || com o operando como valor
+                const bool isAnd = in.op == EfsmVm::JumpIfFalseKeep;
+                const Expr l = st.takeLast();
+                QVector<Expr> sub;
+                if (in.arg <= pc || in.arg > end || !walk(p, pc+1, in.arg, sub, why)) {
+                    if (why.isEmpty()) why = "salto inesperado no bytecode";
+                    return false;
+                }
+                if (sub.size() != 1) { why = "operando malformado"; return false; }
+                const Expr& r = sub[0];
+                if (l.type == Expr::Bool && r.type == Expr::Bool)
+                    st.push_back({ QString("(%1 %2 %3)").arg(l.code, isAnd ? "&&" : "||", r.code), Expr::Bool });
+                else if (l.type == Expr::Int && r.type == Expr::Int)
+                    st.push_back({ QString("[&]() -> int64_t { const int64_t t = %1; return %2; }()")
+                                       .arg(l.code, isAnd ? "t ? " + r.code + " : t" : "t ? t : " + r.code),
+                                   Expr::Int });
+                else
+                    st.push_back({ QString("(%1 %2 %3)").arg(truth(l), isAnd ? "&&" : "||", truth(r)), Expr::Mixed });
+                pc = in.arg;
+                continue;
+            }
+            case EfsmVm::Pop:
+                why = "instrução não suportada";
+                return false;
+            }
+            ++pc;
+        }
+        return true;
+    }
+
+    const QVector<Slot>& slots_;
+    EfsmVm::Resolver resolve_;
+    QHash<int, QString> locals_;     // slot -> local da ação
+    QStringList* stmts_ = nullptr;   // null: guarda
+};
+
+const char* const kRuntime = R"(namespace rt {
+// mesma faixa do VM: inteiros exatos num double JS
+constexpr int64_t kMaxSafe = int64_t(1) << 53;
+inline int64_t safe(int64_t n, bool& ok){
+    if (n < -kMaxSafe || n > kMaxSafe) { ok = false; return 0; }
+    return n;
+}
+inline int64_t add(int64_t a, int64_t b, bool& ok){ return safe(a + b, ok); }
+inline int64_t sub(int64_t a, int64_t b, bool& ok){ return safe(a - b, ok); }
+inline int64_t mul(int64_t a, int64_t b, bool& ok){
+    if (a != 0 && std::llabs(b) > kMaxSafe / std::llabs(a)) { ok = false; return 0; }
+    return a * b;
+}
+inline int64_t mod(int64_t a, int64_t b, bool& ok){   // sinal do dividendo, como no JS
+    if (b == 0) { ok = false; return 0; }
+    return a % b;
+}
+} // namespace rt
+)";
+
+} // namespace
+
+QString EfsmCodegen::toCpp(const EfsmModel& source, const Options& options, Report* report){
+    EfsmModel model = source;
+    model.rebuildIndex();
+    Report rep;
+    rep.transitions = model.transitions.size();
+
+    // slots X | I | O, com a mesma resolução de nomes do engine (nome
+    // repetido entre conjuntos é ambíguo e fica de fora)
+    QVector<Slot> slots;
+    QHash<QString, int> slotOf;
+    QStringList structs;
+    const QVector<EfsmVar>* decls[] = { &model.vars, &model.inputs, &model.outputs };
+    const char* structNames[] = { "Vars", "Inputs", "Outputs" };
+    const char* members[] = { "x", "in", "out" };
+    const char* comments[] = { "X", "I", "O" };
+    for (int d=0; d<3; ++d){
+        QSet<QString> used = { structNames[d] };
+        QStringList fields;
+        for (const auto& v : *decls[d]){
+            const QString id = identifier(v.name, used);
+            Slot s;
+            s.name = v.name;
+            s.path = QString("m.%1.%2").arg(members[d], id);
+            s.type = v.value.type;
+            s.input = d == 1;
+            // um inteiro inicial fora de ±2^53 já seria número inexato no JS
+            if (s.type == EfsmValue::Int && (v.value.i > (qint64(1) << 53) || v.value.i < -(qint64(1) << 53)))
+                s.type = EfsmValue::String;
+            auto it = slotOf.find(v.name);
+            if (it == slotOf.end()) slotOf.insert(v.name, slots.size());
+            else it.value() = -1;
+            slots.push_back(s);
+            fields << QString("        %1 %2 = %3;%4").arg(cppType(v.value.type), id, cppValue(v.value),
+                                                          id != v.name ? "   // " + v.name : QString());
+        }
+        structs << QString("    struct %1 {\n%2%3    } %4;   // %5")
+                       .arg(structNames[d], fields.join('\n'), fields.isEmpty() ? QString() : QString("\n"),
+                            members[d], comments[d]);
+    }
+    Translator tr(slots, slotOf, model.vars.size(), model.inputs.size());
+
+    // estados
+    QSet<QString> usedStates;
+    QStringList stateIds, stateNames, finals;
+    for (const auto& s : model.states){
+        stateIds << identifier(s.name, usedStates);
+        stateNames << cppString(s.name);
+        finals << (s.final ? "true" : "false");
+    }
+
+    // step(): um case por estado, candidatas na ordem (prioridade, id)
+    QStringList body;
+    for (int si=0; si<model.states.size(); ++si){
+        body << QString("    case %1: {   // %2").arg(si).arg(oneLine(model.states[si].name));
+        const QVector<int>& out = model.outgoing(si);
+        if (out.isEmpty()){
+            body << "        return { Status::NoOutgoing, -1 };" << "    }";
+            continue;
+        }
+        for (int ti : out){
+            const EfsmTransition& t = model.transitions[ti];
+            body << QString("        // t%1: %2 -> %3  [%4]  p=%5 id=%6")
+                        .arg(ti).arg(oneLine(model.states[t.from].name), oneLine(model.states[t.to].name),
+                                     oneLine(t.guard)).arg(t.priority).arg(t.id);
+            QString guard, why;
+            QStringList decls, stmts, commits;
+            const bool guardOk = tr.guard(t.guard, guard, why);
+            const bool actionOk = guardOk && tr.action(t.action, decls, stmts, commits, why);
+            if (!guardOk || !actionOk){
+                rep.untranslated << ti;
+                rep.reasons << why;
+                body << QString("        // não traduzida: %1").arg(why);
+                if (!guardOk) { body << QString("        return { Status::Untranslated, %1 };").arg(ti); continue; }
+            }
+            body << "        {"
+                 << QString("            const bool g = %1;").arg(guard)
+                 << QString("            if (!ok) return { Status::Overflow, %1 };").arg(ti)
+                 << "            if (g) {";
+            if (!actionOk){
+                if (!t.action.trimmed().isEmpty()) body << "                // ação: " + oneLine(t.action);
+                body << QString("                return { Status::Untranslated, %1 };").arg(ti);
+            } else {
+                if (!t.action.trimmed().isEmpty()) body << "                // " + oneLine(t.action);
+                for (const auto& l : decls) body << "                " + l;
+                for (const auto& l : stmts) body << "                " + l;
+                if (!stmts.isEmpty())
+                    body << QString("                if (!ok) return { Status::Overflow, %1 };").arg(ti);
+                for (const auto& l : commits) body << "                " + l;
+                body << QString("                m.state = %1;").arg(t.to)
+                     << "                ++m.steps;"
+                     << QString("                return { Status::Fired, %1 };").arg(ti);
+            }
+            body << "            }" << "        }";
+        }
+        body << "        return { Status::NoneEnabled, -1 };" << "    }";
+    }
+
+    QStringList enumerators;
+    for (int i=0; i<stateIds.size(); ++i) enumerators << QString("%1 = %2").arg(stateIds[i]).arg(i);
+
+    QStringList out;
+    out << "// Gerado pelo EFSM Studio (Exportar C++)" + (options.source.isEmpty() ? QString() : " a partir de " + options.source) + ". Não editar."
+        << "//"
+        << "// Machine guarda estado, contador de passos e X/I/O; step() dá um passo com a"
+        << "// mesma escolha do interpretador (primeira guarda verdadeira na ordem"
+        << "// prioridade, id). Overflow: o interpretador cairia para o JS (|n| > 2^53,"
+        << "// % 0). Untranslated: transição fora do subconjunto (ver relatório abaixo).";
+    for (const auto& l : rep.text(model).split('\n')) out << "// " + l;
+    out << "#pragma once"
+        << "#include <cstdint>"
+        << "#include <cstdlib>"
+        << "#include <string>"
+        << ""
+        << QString("namespace %1 {").arg(options.nameSpace)
+        << ""
+        << kRuntime
+        << QString("enum class State : int { %1 };").arg(enumerators.join(", "))
+        << QString("constexpr int kStateCount = %1;").arg(model.states.size())
+        << ""
+        << "struct Machine {"
+        << QString("    int state = %1;   // -1: sem estado inicial").arg(model.initialState())
+        << "    int64_t steps = 0;"
+        << structs
+        << "};"
+        << ""
+        << "enum class Status { Fired, NoCurrentState, NoOutgoing, NoneEnabled, Overflow, Untranslated };"
+        << "struct StepResult { Status status; int transition; };   // índice em model.transitions"
+        << "";
+    if (model.states.isEmpty()){
+        out << "inline const char* stateName(int) { return \"\"; }"
+            << "inline bool isFinal(const Machine&) { return false; }";
+    } else {
+        out << "inline const char* stateName(int s){"
+            << QString("    static const char* const names[] = { %1 };").arg(stateNames.join(", "))
+            << "    return s >= 0 && s < kStateCount ? names[s] : \"\";"
+            << "}"
+            << "inline bool isFinal(const Machine& m){"
+            << QString("    static const bool finals[] = { %1 };").arg(finals.join(", "))
+            << "    return m.state >= 0 && m.state < kStateCount && finals[m.state];"
+            << "}";
+    }
+    out << ""
+        << "inline StepResult step(Machine& m){"
+        << "    bool ok = true;"
+        << "    switch (m.state){"
+        << body
+        << "    default:"
+        << "        return { Status::NoCurrentState, -1 };"
+        << "    }"
+        << "}"
+        << ""
+        << "// como EfsmEngine::run(): até maxSteps (< 0: sem limite), estado final ou um passo que não dispara"
+        << "inline StepResult run(Machine& m, int64_t maxSteps, bool stopAtFinal = true){"
+        << "    StepResult r{ Status::Fired, -1 };"
+        << "    for (int64_t n = 0; maxSteps < 0 || n < maxSteps; ++n){"
+        << "        if (stopAtFinal && isFinal(m)) break;"
+        << "        r = step(m);"
+        << "        if (r.status != Status::Fired) break;"
+        << "    }"
+        << "    return r;"
+        << "}"
+        << ""
+        << QString("} // namespace %1").arg(options.nameSpace)
+        << "";
+
+    if (report) *report = rep;
+    return out.join('\n');
+}
+
+QString EfsmCodegen::Report::text(const EfsmModel& model) const {
+    QStringList lines;
+    lines << QString("%1 de %2 transições traduzidas").arg(transitions - untranslated.size()).arg(transitions);
+    for (int i=0; i<untranslated.size(); ++i){
+        const EfsmTransition& t = model.transitions[untranslated[i]];
+        lines << QString("  t%1 %2 -> %3 [%4]: %5").arg(untranslated[i])
+                     .arg(oneLine(model.states[t.from].name), oneLine(model.states[t.to].name),
+                          oneLine(t.guard), reasons.value(i));
+    }
+    return lines.join('\n');
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "EfsmModel.h"
+#include <QStringList>
+
+// Gerador de C++ (ahead-of-time) a partir de um EfsmModel — os mesmos dados
+// do "Salvar…". Sai um header único, sem dependências além da biblioteca
+// padrão: struct Machine com X/I/O como campos tipados e step() com um
+// switch no estado corrente, candidatas já na ordem (prioridade, id).
+//
+// Guardas e ações são traduzidas a partir do bytecode do EfsmVm, então o
+// subconjunto é exatamente o que roda nativo no interpretador (bool/int,
+// ":="), com a mesma semântica: && e || devolvem o operando, aritmética
+// limitada a |n| <= 2^53, % 0 inválido. Onde o VM cairia para o JS, o código
+// gerado devolve Status::Overflow sem alterar nada.
+//
+// O que não cabe (strings, funções, tipos que mudam numa atribuição…) vira
+// Status::Untranslated quando a transição é alcançada, e aparece no relatório.
+class EfsmCodegen {
+public:
+    struct Options {
+        QString nameSpace = "efsm";
+        QString source;   // origem do modelo (comentário no topo)
+    };
+    struct Report {
+        int transitions = 0;
+        QVector<int> untranslated;   // índices em model.transitions
+        QStringList reasons;         // um por item de untranslated
+        QString text(const EfsmModel& model) const;
+    };
+
+    static QString toCpp(const EfsmModel& model, const Options& options, Report* report = nullptr);
+};
@@ -0,0 +1,46 @@
+// efsm_codegen_fixture: gera, no build dos testes, o header C++ de um modelo
+// salvo (.json) com EfsmCodegen, para efsm_core_tests compilar junto e
+// comparar com o EfsmEngine.
+//
+//   efsm_codegen_fixture modelo.json saida.h
+//
+// Falha (código 1) se o modelo não carrega ou se alguma transição ficou fora
+// do subconjunto traduzido: o fixture deve ser traduzido por inteiro.
+#include "EfsmCodegen.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <cstdio>
+
+int main(int argc, char** argv){
+    if (argc != 3){
+        std::fprintf(stderr, "uso: efsm_codegen_fixture modelo.json saida.h\n");
+        return 1;
+    }
+    const QString path = QString::fromLocal8Bit(argv[1]);
+    QFile in(path);
+    EfsmModel model;
+    QString err;
+    if (!in.open(QIODevice::ReadOnly) || !model.fromJson(QJsonDocument::fromJson(in.readAll()).object(), &err)){
+        std::fprintf(stderr, "efsm_codegen_fixture: %s: %s\n", argv[1],
+                     qPrintable(err.isEmpty() ? in.errorString() : err));
+        return 1;
+    }
+
+    EfsmCodegen::Options opt;
+    opt.nameSpace = "fixture";
+    opt.source = QFileInfo(path).fileName();
+    EfsmCodegen::Report report;
+    const QByteArray code = EfsmCodegen::toCpp(model, opt, &report).toUtf8();
+    if (!report.untranslated.isEmpty()){
+        std::fprintf(stderr, "efsm_codegen_fixture: %s\n", qPrintable(report.text(model)));
+        return 1;
+    }
+
+    QFile out(QString::fromLocal8Bit(argv[2]));
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) || out.write(code) != code.size()){
+        std::fprintf(stderr, "efsm_codegen_fixture: %s: %s\n", argv[2], qPrintable(out.errorString()));
+        return 1;
+    }
+    return 0;
+}
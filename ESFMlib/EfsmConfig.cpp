@@ -0,0 +1,87 @@
+#include "EfsmConfig.h"
+#include <cstring>      // std::memcpy
+
+namespace {
+
+void appendValue(QByteArray& b, const EfsmValue& v){
+    b.append(char(v.type));
+    if (v.type == EfsmValue::String){
+        const qint32 n = v.s.size();
+        b.append(reinterpret_cast<const char*>(&n), sizeof n);
+        b.append(reinterpret_cast<const char*>(v.s.utf16()), n * 2);
+    } else {
+        b.append(reinterpret_cast<const char*>(&v.i), sizeof v.i);
+    }
+}
+
+const char* readValue(const char* p, EfsmValue& v){
+    v.type = EfsmValue::Type(quint8(*p++));
+    if (v.type == EfsmValue::String){
+        qint32 n = 0;
+        std::memcpy(&n, p, sizeof n); p += sizeof n;
+        v.s = QString(reinterpret_cast<const QChar*>(p), n);
+        v.i = 0;
+        return p + n * 2;
+    }
+    std::memcpy(&v.i, p, sizeof v.i);
+    v.s.clear();
+    return p + sizeof v.i;
+}
+
+quint64 mix64(quint64 z){
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+QByteArray EfsmConfig::encode(const EfsmEngine& e, bool withOutputs){
+    const int nx = e.model().vars.size();
+    const int no = withOutputs ? e.model().outputs.size() : 0;
+    QByteArray b;
+    b.reserve(4 + (nx + no) * 9);
+    const qint32 s = e.currentState();
+    b.append(reinterpret_cast<const char*>(&s), sizeof s);
+    for (int k=0; k<nx; ++k) appendValue(b, e.var(k));
+    for (int k=0; k<no; ++k) appendValue(b, e.output(k));
+    return b;
+}
+
+void EfsmConfig::load(EfsmEngine& e, const QByteArray& config, bool withOutputs){
+    const EfsmModel& m = e.model();
+    const char* p = config.constData();
+    qint32 s; std::memcpy(&s, p, sizeof s); p += sizeof s;
+    e.setCurrentState(s);
+    EfsmValue v;
+    for (int k=0; k<m.vars.size(); ++k) { p = readValue(p, v); e.setVar(k, v); }
+    for (int k=0; k<m.outputs.size(); ++k){
+        if (withOutputs) { p = readValue(p, v); e.setOutput(k, v); }
+        else e.setOutput(k, m.outputs[k].value);
+    }
+}
+
+int EfsmConfig::state(const QByteArray& config){
+    qint32 s; std::memcpy(&s, config.constData(), sizeof s);
+    return s;
+}
+
+QVector<EfsmValue> EfsmConfig::values(const QByteArray& config, int count){
+    QVector<EfsmValue> out(count);
+    const char* p = config.constData() + sizeof(qint32);
+    for (auto& v : out) p = readValue(p, v);
+    return out;
+}
+
+quint64 EfsmConfig::fingerprint(const QByteArray& config){
+    quint64 h = 0x9e3779b97f4a7c15ull ^ quint64(config.size());
+    const char* p = config.constData();
+    int n = config.size();
+    for (; n >= 8; p += 8, n -= 8){
+        quint64 w; std::memcpy(&w, p, 8);
+        h = mix64(h ^ w);
+    }
+    quint64 tail = 0;
+    std::memcpy(&tail, p, n);
+    return mix64(h ^ tail);
+}
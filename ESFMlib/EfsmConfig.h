@@ -0,0 +1,24 @@
+#pragma once
+#include "EfsmEngine.h"
+#include <QByteArray>
+
+// Configuração (estado, X e opcionalmente O) de um EfsmEngine numa forma
+// compacta e comparável byte a byte, para deduplicar configurações por
+// impressão digital de 64 bits (exploração, geração de testes). A impressão
+// não é única: quem deduplica só por ela aceita uma chance (pequena) de
+// tratar duas configurações distintas como a mesma.
+//
+// Formato: [estado:int32][slot…], slot = [tipo:u8][int64]
+//                                      ou [tipo:u8][n:int32][utf16 × n]
+class EfsmConfig {
+public:
+    static QByteArray encode(const EfsmEngine& e, bool withOutputs);
+    // restaura estado, X e O (sem O no código: O volta aos valores do modelo)
+    static void load(EfsmEngine& e, const QByteArray& config, bool withOutputs);
+
+    static int state(const QByteArray& config);
+    // os primeiros count slots (X, depois O) na ordem do código
+    static QVector<EfsmValue> values(const QByteArray& config, int count);
+
+    static quint64 fingerprint(const QByteArray& config);
+};
@@ -0,0 +1,825 @@
+// Testes do núcleo (EFSMCore), sem GUI: ctest ou ./efsm_core_tests
+//
+// Modelo de referência ("contador"): A (inicial) conta n até 5 enquanto go,
+// depois vai para B (final) marcando flag; o := 2n a cada contagem.
+#include "EfsmBatch.h"
+#include "EfsmCheckpoint.h"
+#include "EfsmCodegen.h"
+#include "EfsmCoverage.h"
+#include "EfsmEngine.h"
+#include "EfsmExplorer.h"
+#include "EfsmHistory.h"
+#include "EfsmReplay.h"
+#include "EfsmVm.h"
+#include "EfsmWorker.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSignalSpy>
+#include <QtTest>
+#include "codegen_fixture.h"   // gerado de EfsmCodegenFixture.json no build
+
+namespace {
+
+EfsmModel counterModel(bool forceJs = false){
+    // forceJs: mesmos scripts com um termo fora do subconjunto do VM
+    const QString js = forceJs ? QStringLiteral(" + Math.abs(0)") : QString();
+    EfsmModel m;
+    m.vars    = { { "n", EfsmValue::fromInt(0) }, { "flag", EfsmValue::fromBool(false) } };
+    m.inputs  = { { "go", EfsmValue::fromBool(false) } };
+    m.outputs = { { "o", EfsmValue::fromInt(0) } };
+    EfsmState a; a.name = "A"; a.initial = true;
+    EfsmState b; b.name = "B"; b.final = true;
+    m.states = { a, b };
+    EfsmTransition count;
+    count.id = 1; count.from = 0; count.to = 0;
+    count.guard  = forceJs ? "go && n < 5 && Math.abs(0) == 0" : "go && n < 5";
+    count.action = "n := n + 1" + js + "; o := n * 2" + js;
+    EfsmTransition done;
+    done.id = 2; done.from = 0; done.to = 1;
+    done.guard  = forceJs ? "n >= 5 && Math.abs(0) == 0" : "n >= 5";
+    done.action = "flag := true";
+    m.transitions = { count, done };
+    m.rebuildIndex();
+    return m;
+}
+
+// um estado, self-loop incondicional: passos sem fim
+EfsmModel loopModel(const QString& action = "n := n + 1; o := n % 3"){
+    EfsmModel m;
+    m.vars    = { { "n", EfsmValue::fromInt(0) } };
+    m.outputs = { { "o", EfsmValue::fromInt(0) } };
+    EfsmState l; l.name = "L"; l.initial = true;
+    m.states = { l };
+    EfsmTransition t;
+    t.id = 1; t.from = 0; t.to = 0;
+    t.action = action;
+    m.transitions = { t };
+    m.rebuildIndex();
+    return m;
+}
+
+// saída que recusa toda escrita (disco cheio, pipe fechado…), sem avisos
+class FailingDevice : public QIODevice {
+protected:
+    qint64 readData(char*, qint64) override { return -1; }
+    qint64 writeData(const char*, qint64) override { return -1; }
+};
+
+// cabeçalho do checkpoint escrito à mão (mesmo formato de toBinary())
+QByteArray checkpointHeader(qint32 stateCount, qint32 state, qint32 nx, qint32 ni, qint32 no){
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_12);
+    out << quint32(0x4546434b) << quint16(1)
+        << stateCount << state << QString("A") << qint64(0) << nx << ni << no;
+    return data;
+}
+
+// espera o worker (finished() chega por fila à thread do teste)
+EfsmWorker::Result waitWorker(EfsmWorker& w, QSignalSpy& finished){
+    for (int k=0; k<500 && w.isRunning(); ++k) QTest::qWait(10);
+    if (w.isRunning() || finished.isEmpty()) return EfsmWorker::Result();
+    return finished.takeFirst().at(0).value<EfsmWorker::Result>();
+}
+
+// o mesmo modelo de que o build gerou codegen_fixture.h
+EfsmModel codegenFixture(){
+    QFile f(QStringLiteral(EFSM_CODEGEN_FIXTURE));
+    EfsmModel m;
+    if (f.open(QIODevice::ReadOnly)) m.fromJson(QJsonDocument::fromJson(f.readAll()).object());
+    return m;
+}
+
+// passo do código gerado contra o do engine: mesmo status, transição, estado e X/O
+void compareCodegenStep(fixture::Machine& m, EfsmEngine& e, qint64 op, qint64 k, bool flag,
+                        int expectTransition){
+    m.in.op = op;
+    m.in.k = k;
+    m.in.flag = flag;
+    e.setInput(0, EfsmValue::fromInt(op));
+    e.setInput(1, EfsmValue::fromInt(k));
+    e.setInput(2, EfsmValue::fromBool(flag));
+    const fixture::StepResult g = fixture::step(m);
+    const EfsmEngine::StepResult r = e.step();
+    QCOMPARE(g.transition, expectTransition);
+    QCOMPARE(r.transition, expectTransition);
+    if (expectTransition >= 0){
+        QCOMPARE(g.status, fixture::Status::Fired);
+        QCOMPARE(r.status, EfsmEngine::StepStatus::Fired);
+    } else {
+        QCOMPARE(g.status, fixture::Status::NoneEnabled);
+        QCOMPARE(r.status, EfsmEngine::StepStatus::NoneEnabled);
+    }
+    QCOMPARE(m.state, e.currentState());
+    QCOMPARE(qint64(m.steps), e.stepCount());
+    QCOMPARE(qint64(m.x.n), e.var(0).i);
+    QCOMPARE(qint64(m.x.a), e.var(1).i);
+    QCOMPARE(qint64(m.x.r), e.var(2).i);
+    QCOMPARE(m.x.e, e.var(3).i != 0);
+    QCOMPARE(qint64(m.out.o), e.output(0).i);
+}
+
+} // namespace
+
+class EfsmCoreTests : public QObject {
+    Q_OBJECT
+
+private slots:
+    void modelJsonRoundTrip();
+    void engineRunsCounter();
+    void actionVarIsSessionGlobal();
+    void vmSubset();
+    void vmAgreesWithJs();
+    void sortedIndexMaintained();
+    void batchIsDeterministic();
+    void replayWritesChanges();
+    void replayReportsWriteError();
+    void explorerCounts();
+    void explorerActionErrorIsNotDeadlock();
+    void explorerDomainFromJson();
+    void coverageSuite();
+    void coverageScalesToManyTransitions();
+    void guardMemoInvalidation();
+    void historyStepBackAndJump();
+    void historyEvictionAndBranch();
+    void checkpointRoundTrip();
+    void checkpointRejectsCorruptInput();
+    void breakpointEdges();
+    void workerResumesAfterCondition();
+    void workerCancel();
+    void workerWatchdogTimeout();
+    void codegenMatchesEngine();
+    void codegenOverflowAtSafeLimit();
+};
+
+void EfsmCoreTests::modelJsonRoundTrip(){
+    const EfsmModel m = counterModel();
+    EfsmModel r;
+    QString err;
+    QVERIFY2(r.fromJson(m.toJson(), &err), qPrintable(err));
+    QCOMPARE(r.states.size(), 2);
+    QCOMPARE(r.initialState(), 0);
+    QCOMPARE(r.stateIndex("B"), 1);
+    QVERIFY(r.states[1].final);
+    QCOMPARE(r.transitions.size(), 2);
+    QCOMPARE(r.transitions[1].guard, QString("n >= 5"));
+    QCOMPARE(r.outgoing(0).size(), 2);
+    QVERIFY(r.outgoing(1).isEmpty());
+    QCOMPARE(r.vars.size(), 2);
+    QCOMPARE(r.vars[1].value, EfsmValue::fromBool(false));
+    QCOMPARE(r.inputs[0].name, QString("go"));
+
+    QVERIFY(!r.fromJson(QJsonObject(), &err));
+    QVERIFY(!err.isEmpty());
+}
+
+void EfsmCoreTests::engineRunsCounter(){
+    EfsmEngine e(counterModel());
+    QCOMPARE(e.currentState(), 0);
+    QCOMPARE(int(e.step().status), int(EfsmEngine::StepStatus::NoneEnabled));   // go = false
+
+    e.setInput(0, EfsmValue::fromBool(true));
+    for (int k=1; k<=5; ++k){
+        const EfsmEngine::StepResult r = e.step();
+        QCOMPARE(int(r.status), int(EfsmEngine::StepStatus::Fired));
+        QCOMPARE(r.transition, 0);
+        QCOMPARE(e.var(0).i, qint64(k));
+        QCOMPARE(e.output(0).i, qint64(2 * k));
+    }
+    const EfsmEngine::StepResult r = e.step();
+    QCOMPARE(r.transition, 1);
+    QVERIFY(e.isFinal());
+    QCOMPARE(e.var(1), EfsmValue::fromBool(true));
+    QCOMPARE(int(e.step().status), int(EfsmEngine::StepStatus::NoOutgoing));
+
+    e.reset();
+    QCOMPARE(e.currentState(), 0);
+    QCOMPARE(e.var(0).i, qint64(0));
+}
+
+void EfsmCoreTests::actionVarIsSessionGlobal(){
+    // ações rodam no escopo global do script: um var declarado numa ação
+    // continua na sessão JS até ela ser descartada
+    EfsmEngine e(loopModel("var seen = typeof seen == 'undefined' ? 1 : seen + 1; o := seen"));
+    e.step();
+    e.step();
+    QCOMPARE(e.output(0).i, qint64(2));
+    e.reset();   // mesma sessão
+    e.step();
+    QCOMPARE(e.output(0).i, qint64(3));
+    e.resetSession();
+    e.step();
+    QCOMPARE(e.output(0).i, qint64(1));
+}
+
+void EfsmCoreTests::vmSubset(){
+    // slots: 0 = n (int), 1 = b (bool)
+    const EfsmVm::Resolver resolve = [](const QString& name, bool){
+        return name == "n" ? 0 : name == "b" ? 1 : -1;
+    };
+    EfsmValue slots[2] = { EfsmValue::fromInt(3), EfsmValue::fromBool(false) };
+    auto guard = [&](const QString& text, EfsmValue& out){
+        EfsmVm::Program p;
+        if (!EfsmVm::compileGuard(text, resolve, p)) return false;
+        return EfsmVm::run(p, slots, &out) == EfsmVm::Result::Ok;
+    };
+    EfsmValue v;
+    QVERIFY(guard("n && 7", v));        // && e || devolvem o operando
+    QCOMPARE(v, EfsmValue::fromInt(7));
+    QVERIFY(guard("b || n", v));
+    QCOMPARE(v, EfsmValue::fromInt(3));
+    QVERIFY(guard("-7 % n", v));        // sinal do dividendo, como no JS
+    QCOMPARE(v, EfsmValue::fromInt(-1));
+    QVERIFY(guard("b === 0", v));       // tipos diferentes
+    QCOMPARE(v, EfsmValue::fromBool(false));
+    QVERIFY(guard("b == 0", v));
+    QCOMPARE(v, EfsmValue::fromBool(true));
+    QVERIFY(!guard("n % 0", v));        // compila, mas cai para o JS
+    QVERIFY(!guard("9007199254740992 * n", v));
+    EfsmVm::Program p;
+    QVERIFY(!EfsmVm::compileGuard("Math.abs(n) > 1", resolve, p));
+    QVERIFY(!EfsmVm::compileAction("x := 1", resolve, p));   // nome desconhecido
+
+    QVERIFY(EfsmVm::compileAction("n := n * 2; b := n > 5", resolve, p));
+    QCOMPARE(EfsmVm::run(p, slots), EfsmVm::Result::Ok);
+    QCOMPARE(slots[0], EfsmValue::fromInt(6));
+    QCOMPARE(slots[1], EfsmValue::fromBool(true));
+}
+
+void EfsmCoreTests::vmAgreesWithJs(){
+    EfsmEngine vm(counterModel(false));
+    EfsmEngine js(counterModel(true));
+    for (int k=0; k<12; ++k){
+        const EfsmValue go = EfsmValue::fromBool(k % 3 != 1);
+        vm.setInput(0, go);
+        js.setInput(0, go);
+        const EfsmEngine::StepResult a = vm.step();
+        const EfsmEngine::StepResult b = js.step();
+        QCOMPARE(int(a.status), int(b.status));
+        QCOMPARE(a.transition, b.transition);
+        QCOMPARE(vm.currentState(), js.currentState());
+        QVERIFY(vm.values() == js.values());
+    }
+    QVERIFY(vm.isFinal());
+    QCOMPARE(vm.var(0).i, qint64(5));
+    QCOMPARE(vm.output(0).i, qint64(10));
+}
+
+void EfsmCoreTests::sortedIndexMaintained(){
+    EfsmModel m;
+    EfsmState a; a.name = "A"; a.initial = true;
+    EfsmState b; b.name = "B";
+    m.states = { a, b };
+    auto make = [](int id, int from, int priority){
+        EfsmTransition t;
+        t.id = id; t.from = from; t.to = 1; t.priority = priority;
+        return t;
+    };
+    m.transitions = { make(1, 0, 2), make(2, 0, 1), make(3, 1, 1), make(4, 0, 2) };
+    m.rebuildIndex();
+    QCOMPARE(m.outgoing(0), (QVector<int>{ 1, 0, 3 }));   // (prioridade, id)
+
+    QCOMPARE(m.addTransition(make(5, 0, 0)), 4);
+    QCOMPARE(m.outgoing(0), (QVector<int>{ 4, 1, 0, 3 }));
+    QCOMPARE(m.addTransition(make(6, 0, 2)), 5);            // empate: id maior vai depois
+    QCOMPARE(m.outgoing(0), (QVector<int>{ 4, 1, 0, 3, 5 }));
+
+    m.setTransitionPriority(0, 3);
+    QCOMPARE(m.outgoing(0), (QVector<int>{ 4, 1, 3, 5, 0 }));
+    m.setTransitionPriority(0, 2);                          // volta ao lugar pelo id
+    QCOMPARE(m.outgoing(0), (QVector<int>{ 4, 1, 0, 3, 5 }));
+
+    m.removeTransition(1);   // a última (id 6) passa a ocupar o índice 1
+    QCOMPARE(m.transitions[1].id, 6);
+    QCOMPARE(m.outgoing(0), (QVector<int>{ 4, 0, 3, 1 }));
+    QCOMPARE(m.outgoing(1), (QVector<int>{ 2 }));
+
+    // o incremental bate com a reconstrução do zero
+    EfsmModel fresh = m;
+    fresh.rebuildIndex();
+    QCOMPARE(fresh.outgoing(0), m.outgoing(0));
+
+    // e o engine escolhe a primeira habilitada nessa ordem
+    EfsmEngine e(counterModel());
+    e.setInput(0, EfsmValue::fromBool(true));
+    e.setPriority(1, 0);   // "done" na frente de "count"
+    e.setVar(0, EfsmValue::fromInt(2));
+    QCOMPARE(e.step().transition, 0);   // n < 5: "done" desabilitada
+    e.setVar(0, EfsmValue::fromInt(5));
+    QCOMPARE(e.step().transition, 1);
+}
+
+void EfsmCoreTests::batchIsDeterministic(){
+    const EfsmModel m = counterModel();
+    QVector<EfsmScenario> scenarios;
+    for (int k=0; k<40; ++k){
+        EfsmScenario sc;
+        sc.name = QString("s%1").arg(k);
+        sc.vars.insert("n", EfsmValue::fromInt(k % 7));
+        sc.inputs.insert("go", EfsmValue::fromBool(false));
+        for (int r=0; r<k % 5; ++r)
+            sc.trace.push_back({ { "go", EfsmValue::fromBool(r % 2 == 1) } });
+        sc.trace.push_back({ { "go", EfsmValue::fromBool(k % 3 != 0) } });
+        sc.maxSteps = 20;
+        scenarios.push_back(sc);
+    }
+
+    const QVector<EfsmScenarioResult> one = EfsmBatch::run(m, scenarios, 1);
+    const QVector<EfsmScenarioResult> many = EfsmBatch::run(m, scenarios, 8);
+    QCOMPARE(one.size(), scenarios.size());
+    QCOMPARE(many.size(), scenarios.size());
+    for (int k=0; k<one.size(); ++k){
+        QCOMPARE(many[k].name, scenarios[k].name);
+        QCOMPARE(many[k].finalState, one[k].finalState);
+        QCOMPARE(many[k].steps, one[k].steps);
+        QCOMPARE(int(many[k].status), int(one[k].status));
+        QCOMPARE(many[k].reachedFinal, one[k].reachedFinal);
+        QVERIFY(many[k].vars == one[k].vars);
+        QVERIFY(many[k].outputs == one[k].outputs);
+        QVERIFY(!one[k].cancelled);
+    }
+    QCOMPARE(one[5].finalState, 1);   // n = 5 e go: "done" leva a B
+    QCOMPARE(one[0].finalState, 0);   // go = false: parado em A
+
+    // global JS deixado pela ação: cada cenário começa do zero, com 1 ou 8 threads
+    const EfsmModel js = loopModel("var calls = typeof calls == 'undefined' ? 1 : calls + 1; o := calls");
+    QVector<EfsmScenario> loops(16);
+    for (auto& sc : loops) sc.maxSteps = 3;
+    for (int threads : { 1, 8 }){
+        for (const EfsmScenarioResult& r : EfsmBatch::run(js, loops, threads)){
+            QCOMPARE(r.steps, qint64(3));
+            QCOMPARE(r.outputs.value(0).i, qint64(3));
+        }
+    }
+}
+
+void EfsmCoreTests::replayWritesChanges(){
+    QByteArray input("go\n");
+    for (int k=0; k<8; ++k) input += "true\n";
+    QBuffer in(&input);
+    in.open(QIODevice::ReadOnly);
+    QByteArray output;
+    QBuffer out(&output);
+    out.open(QIODevice::WriteOnly);
+
+    EfsmReplay::Options opt;
+    opt.batchRows = 2;   // força vários lotes pelas filas
+    const EfsmReplay::Stats st = EfsmReplay::run(counterModel(), in, out, opt);
+    QVERIFY2(st.writeError.isEmpty(), qPrintable(st.writeError));
+    QCOMPARE(st.steps, qint64(6));
+    QCOMPARE(st.rows, qint64(7));   // a sétima linha já encontra B sem saídas
+    QCOMPARE(int(st.lastStatus), int(EfsmEngine::StepStatus::NoOutgoing));
+
+    const QList<QByteArray> lines = output.trimmed().split('\n');
+    QCOMPARE(lines.size(), 6);
+    QVERIFY(lines.first().contains("\"n\":1"));
+    QVERIFY(lines.last().contains("\"state\":\"B\""));
+    QVERIFY(lines.last().contains("\"flag\":true"));
+}
+
+void EfsmCoreTests::replayReportsWriteError(){
+    QByteArray input("go\ntrue\ntrue\n");
+    QBuffer in(&input);
+    in.open(QIODevice::ReadOnly);
+    FailingDevice out;
+    out.open(QIODevice::WriteOnly);
+
+    const EfsmReplay::Stats st = EfsmReplay::run(counterModel(), in, out);
+    QVERIFY(!st.writeError.isEmpty());
+    QVERIFY(st.summary().contains(st.writeError));
+}
+
+void EfsmCoreTests::explorerCounts(){
+    const EfsmModel m = counterModel();
+    EfsmExplorer::Options opt;
+    opt.inputs = { { "go", { EfsmValue::fromBool(false), EfsmValue::fromBool(true) } } };
+    opt.threads = 4;
+    const EfsmExplorer::Result r = EfsmExplorer::explore(m, opt);
+    QVERIFY(r.complete);
+    QCOMPARE(r.configurations, qint64(7));   // A com n = 0…5, depois B
+    QCOMPARE(r.edges, qint64(7));            // 5 contagens + "done" com go = false/true
+    QCOMPARE(r.deadlocks, qint64(0));
+    QCOMPARE(r.actionErrors, qint64(0));
+    QCOMPARE(r.stateReached.count(true), 2);
+    QCOMPARE(r.transitionFired.count(true), 2);
+    QVERIFY(r.collisionProbability() < 1e-15);
+}
+
+void EfsmCoreTests::explorerActionErrorIsNotDeadlock(){
+    EfsmModel m = counterModel();
+    m.transitions[0].action = "n := semDefinicao()";   // ReferenceError no JS
+    EfsmExplorer::Options opt;
+    opt.inputs = { { "go", { EfsmValue::fromBool(false), EfsmValue::fromBool(true) } } };
+    const EfsmExplorer::Result r = EfsmExplorer::explore(m, opt);
+    QCOMPARE(r.configurations, qint64(1));
+    QCOMPARE(r.actionErrors, qint64(1));
+    QCOMPARE(r.errorStuck, qint64(1));
+    QCOMPARE(r.deadlocks, qint64(0));   // go = true habilitou, só a ação falhou
+}
+
+void EfsmCoreTests::explorerDomainFromJson(){
+    EfsmModel m = counterModel();
+    m.inputs.push_back({ "k", EfsmValue::fromInt(0) });
+    auto domain = [&](const char* json, EfsmExplorer::Options& opt, QString& err){
+        return EfsmExplorer::Options::fromJson(QJsonDocument::fromJson(json).object(), m, opt, &err);
+    };
+    EfsmExplorer::Options opt;
+    QString err;
+
+    QVERIFY2(domain(R"({"inputs":{"go":"bool","k":[2,5]}})", opt, err), qPrintable(err));
+    QCOMPARE(opt.inputs.size(), 2);
+    QCOMPARE(opt.inputs[0].values.size(), 2);
+    QCOMPARE(opt.inputs[1].values.size(), 4);   // [lo,hi] é intervalo
+    QVERIFY2(domain(R"({"inputs":{"k":{"values":[2,5]}}})", opt, err), qPrintable(err));
+    QCOMPARE(opt.inputs[0].values, (QVector<EfsmValue>{ EfsmValue::fromInt(2), EfsmValue::fromInt(5) }));
+    QVERIFY2(domain(R"({"inputs":{"k":{"range":[-1,1]}}})", opt, err), qPrintable(err));
+    QCOMPARE(opt.inputs[0].values.size(), 3);
+    QVERIFY2(domain(R"({"inputs":{"k":[1,2,3]}})", opt, err), qPrintable(err));
+    QCOMPARE(opt.inputs[0].values.size(), 3);
+    QVERIFY2(domain(R"({"inputs":{"k":[0,4095]}})", opt, err), qPrintable(err));
+    QCOMPARE(opt.inputs[0].values.size(), int(EfsmExplorer::Options::kMaxRangeValues));
+
+    QVERIFY(!domain(R"({"inputs":{"k":[5,2]}})", opt, err));            // hi < lo
+    QVERIFY(err.contains("invertido"));
+    QVERIFY(!domain(R"({"inputs":{"k":[0,4096]}})", opt, err));         // acima do limite
+    QVERIFY(!domain(R"({"inputs":{"k":[0,1e15]}})", opt, err));
+    QVERIFY(!domain(R"({"inputs":{"k":{"range":[0,"x"]}}})", opt, err));
+    QVERIFY(!domain(R"({"inputs":{"nada":"bool"}})", opt, err));        // input desconhecido
+}
+
+void EfsmCoreTests::coverageSuite(){
+    EfsmModel m = counterModel();
+    EfsmTransition never;
+    never.id = 3; never.from = 0; never.to = 1;
+    never.guard = "n < 0";
+    m.transitions.push_back(never);
+    m.rebuildIndex();
+    EfsmExplorer::Options opt;
+    opt.inputs = { { "go", { EfsmValue::fromBool(false), EfsmValue::fromBool(true) } } };
+
+    const EfsmCoverage::Suite suite = EfsmCoverage::generate(m, opt);
+    QVERIFY(suite.complete);
+    QCOMPARE(suite.covered, (QVector<bool>{ true, true, false }));
+    // o caminho até "done" já passa por "count": um teste basta
+    QCOMPARE(suite.tests.size(), 1);
+    const EfsmCoverage::Test& t = suite.tests[0];
+    QCOMPARE(t.transitions, (QVector<int>{ 0, 0, 0, 0, 0, 1 }));
+    QCOMPARE(t.rows.size(), 6);
+    QCOMPARE(t.rows[0], (QVector<EfsmValue>{ EfsmValue::fromBool(true) }));
+    QCOMPARE(t.rows[5], (QVector<EfsmValue>{ EfsmValue::fromBool(false) }));   // menor combinação
+    QVERIFY(suite.summary(m).contains("n < 0"));
+
+    // o teste gerado reproduz o mesmo caminho
+    EfsmEngine e(m);
+    for (int k=0; k<t.rows.size(); ++k){
+        e.setInput(0, t.rows[k][0]);
+        QCOMPARE(e.step().transition, t.transitions[k]);
+    }
+    QVERIFY(e.isFinal());
+}
+
+void EfsmCoreTests::coverageScalesToManyTransitions(){
+    // cadeia S0 -> S1 -> … -> S100, 50 transições por elo (guarda k == j):
+    // 5000 transições e 5000 candidatos para a cobertura gulosa
+    const int levels = 100, fanout = 50;
+    EfsmModel m;
+    m.inputs = { { "k", EfsmValue::fromInt(0) } };
+    for (int i=0; i<=levels; ++i){
+        EfsmState s;
+        s.name = QString("S%1").arg(i);
+        s.initial = i == 0;
+        m.states.push_back(s);
+    }
+    for (int i=0; i<levels; ++i)
+        for (int j=0; j<fanout; ++j){
+            EfsmTransition t;
+            t.id = m.transitions.size() + 1;
+            t.from = i; t.to = i + 1;
+            t.guard = QString("k == %1").arg(j);
+            m.transitions.push_back(t);
+        }
+    m.rebuildIndex();
+    EfsmExplorer::InputDomain k{ "k", {} };
+    for (int j=0; j<fanout; ++j) k.values.push_back(EfsmValue::fromInt(j));
+    EfsmExplorer::Options opt;
+    opt.inputs = { k };
+
+    QElapsedTimer clock;
+    clock.start();
+    const EfsmCoverage::Suite suite = EfsmCoverage::generate(m, opt);
+    const qint64 ms = clock.elapsed();
+    QVERIFY(suite.complete);
+    QCOMPARE(suite.covered.count(true), levels * fanout);
+    // um teste pela cadeia inteira (k = 0), depois um por transição restante
+    QCOMPARE(suite.tests.size(), 1 + levels * (fanout - 1));
+    QCOMPARE(suite.tests[0].rows.size(), levels);
+    QVERIFY2(ms < 10000, qPrintable(QString("%1 ms").arg(ms)));
+}
+
+void EfsmCoreTests::guardMemoInvalidation(){
+    EfsmModel m;
+    m.vars   = { { "b", EfsmValue::fromInt(0) } };
+    m.inputs = { { "x", EfsmValue::fromInt(0) } };
+    EfsmState a; a.name = "A"; a.initial = true;
+    m.states = { a };
+    EfsmTransition t;
+    t.id = 1; t.from = 0; t.to = 0;
+    t.guard  = "x > 0";     // lê só x
+    t.action = "b := b + 1";
+    m.transitions = { t };
+    m.rebuildIndex();
+
+    EfsmEngine e(m);
+    auto expect = [&](EfsmEngine::StepStatus status, qint64 evaluated, qint64 cached){
+        QCOMPARE(e.step().status, status);
+        QCOMPARE(e.guardStats().evaluated, evaluated);
+        QCOMPARE(e.guardStats().cached, cached);
+    };
+    using S = EfsmEngine::StepStatus;
+    expect(S::NoneEnabled, 1, 0);
+    e.setVar(0, EfsmValue::fromInt(5));     // slot fora da leitura: memo vale
+    expect(S::NoneEnabled, 1, 1);
+    e.setInput(0, EfsmValue::fromInt(0));   // mesmo valor: não é escrita
+    expect(S::NoneEnabled, 1, 2);
+    e.setInput(0, EfsmValue::fromInt(1));   // x mudou: reavalia
+    expect(S::Fired, 2, 2);
+    expect(S::Fired, 2, 3);                 // a ação só escreveu b
+    QCOMPARE(e.var(0).i, qint64(7));
+
+    e.setGuard(0, "b < 8");                 // guarda nova: memo novo
+    expect(S::Fired, 3, 3);
+    expect(S::NoneEnabled, 4, 3);           // a ação escreveu b, que agora é lido
+    e.reset();                              // invalida tudo
+    expect(S::Fired, 5, 3);
+
+    // leitura desconhecida (chamada): avaliada a cada passo
+    e.setGuard(0, "Math.abs(x) > 0");
+    e.setInput(0, EfsmValue::fromInt(1));
+    expect(S::Fired, 6, 3);
+    expect(S::Fired, 7, 3);
+}
+
+void EfsmCoreTests::historyStepBackAndJump(){
+    EfsmEngine e(counterModel());
+    EfsmHistory h;
+    e.setHistory(&h);
+    e.setInput(0, EfsmValue::fromBool(true));
+    for (int k=0; k<6; ++k) QCOMPARE(int(e.step().status), int(EfsmEngine::StepStatus::Fired));
+    QCOMPARE(h.firstStep(), qint64(0));
+    QCOMPARE(h.lastStep(), qint64(6));
+    QCOMPARE(h.transitionAt(6), 1);
+
+    QVERIFY(h.restore(5, e));   // um passo para trás
+    QCOMPARE(e.currentState(), 0);
+    QCOMPARE(e.var(0).i, qint64(5));
+    QCOMPARE(e.var(1).i, qint64(0));
+    QCOMPARE(e.stepCount(), qint64(5));
+
+    QVERIFY(h.restore(2, e));   // salto
+    QCOMPARE(e.var(0).i, qint64(2));
+    QCOMPARE(e.output(0).i, qint64(4));
+
+    QVERIFY(h.restore(6, e));   // e de volta ao fim
+    QVERIFY(e.isFinal());
+    QCOMPARE(e.var(1).i, qint64(1));
+    QVERIFY(!h.restore(7, e));
+}
+
+void EfsmCoreTests::historyEvictionAndBranch(){
+    EfsmEngine e(loopModel());
+    EfsmHistory h(50);
+    e.setHistory(&h);
+    for (int k=0; k<300; ++k) e.step();   // atravessa vários quadros-chave
+    QCOMPARE(h.lastStep(), qint64(300));
+    QCOMPARE(h.firstStep(), qint64(251));
+    QVERIFY(!h.restore(250, e));
+
+    for (qint64 s : { 251, 256, 257, 299, 300 }){
+        QVERIFY(h.restore(s, e));
+        QCOMPARE(e.var(0).i, s);
+        QCOMPARE(e.output(0).i, s % 3);
+    }
+
+    QVERIFY(h.restore(260, e));
+    e.step();                           // ramo novo a partir de 260
+    QCOMPARE(h.lastStep(), qint64(261));
+    QVERIFY(h.restore(258, e));
+    QCOMPARE(e.var(0).i, qint64(258));
+    QVERIFY(h.restore(261, e));
+    QCOMPARE(e.var(0).i, qint64(261));
+}
+
+void EfsmCoreTests::checkpointRoundTrip(){
+    const EfsmModel m = counterModel();
+    EfsmEngine e(m);
+    e.setInput(0, EfsmValue::fromBool(true));
+    for (int k=0; k<3; ++k) e.step();
+
+    EfsmCheckpoint cp;
+    QString err;
+    QVERIFY2(EfsmCheckpoint::fromBinary(EfsmCheckpoint::capture(e).toBinary(), cp, &err, &m), qPrintable(err));
+
+    EfsmEngine r(m);
+    QVERIFY2(cp.apply(r, &err), qPrintable(err));
+    QCOMPARE(r.currentState(), e.currentState());
+    QCOMPARE(r.stepCount(), qint64(3));
+    QVERIFY(r.values() == e.values());
+}
+
+void EfsmCoreTests::checkpointRejectsCorruptInput(){
+    const EfsmModel m = counterModel();
+    EfsmCheckpoint cp;
+    QString err;
+
+    const QByteArray good = EfsmCheckpoint::capture(EfsmEngine(m)).toBinary();
+    QVERIFY(EfsmCheckpoint::fromBinary(good, cp, &err));
+    QVERIFY(!EfsmCheckpoint::fromBinary(good.left(good.size() - 3), cp, &err));     // truncado
+    QVERIFY(!EfsmCheckpoint::fromBinary(QByteArray("not a checkpoint"), cp, &err));
+
+    QVERIFY(!EfsmCheckpoint::fromBinary(checkpointHeader(2, 2, 0, 0, 0), cp, &err));    // estado >= contagem
+    QVERIFY(!EfsmCheckpoint::fromBinary(checkpointHeader(2, -2, 0, 0, 0), cp, &err));   // estado < -1
+    QVERIFY(!EfsmCheckpoint::fromBinary(checkpointHeader(2, 0, -1, 0, 0), cp, &err));
+    // soma que estouraria em int; e contagens maiores que o arquivo
+    QVERIFY(!EfsmCheckpoint::fromBinary(checkpointHeader(2, 0, 0x7fffffff, 0x7fffffff, 2), cp, &err));
+    QVERIFY(!EfsmCheckpoint::fromBinary(checkpointHeader(2, 0, 1000000, 0, 0), cp, &err));
+    // contagens que não batem com o modelo
+    QVERIFY(!EfsmCheckpoint::fromBinary(checkpointHeader(2, 0, 0, 0, 0), cp, &err, &m));
+
+    // tipo desconhecido no primeiro valor
+    QByteArray badType = checkpointHeader(2, 0, 1, 0, 0);
+    {
+        QBuffer buf(&badType);
+        buf.open(QIODevice::Append);
+        QDataStream out(&buf);
+        out.setVersion(QDataStream::Qt_5_12);
+        out << QString("n") << quint8(EfsmValue::String + 1) << qint64(0);
+    }
+    QVERIFY(!EfsmCheckpoint::fromBinary(badType, cp, &err));
+    QVERIFY(!err.isEmpty());
+}
+
+void EfsmCoreTests::breakpointEdges(){
+    using Bp = EfsmEngine::Breakpoint;
+    EfsmEngine e(counterModel());
+    e.setInput(0, EfsmValue::fromBool(true));
+    Bp odd;
+    odd.condition = "n % 2 == 1";
+    Bp enterB;
+    enterB.kind = Bp::Kind::EnterState;
+    enterB.index = 1;
+    e.setBreakpoints({ odd, enterB });
+
+    // a condição só para na subida (falsa -> verdadeira): n = 1, 3, 5
+    const EfsmEngine::RunLimits free;
+    for (qint64 n : { 1, 3, 5 }){
+        const EfsmEngine::RunResult r = e.run(free);
+        QCOMPARE(r.breakpoint, 0);
+        QCOMPARE(e.var(0).i, n);
+    }
+    // "done" mantém n ímpar (sem nova subida); entrar em B para
+    const EfsmEngine::RunResult r = e.run(free);
+    QCOMPARE(r.steps, qint64(1));
+    QCOMPARE(r.breakpoint, 1);
+    QVERIFY(e.isFinal());
+
+    // transição: para a cada disparo, e tem precedência sobre a condição
+    EfsmEngine t(counterModel());
+    t.setInput(0, EfsmValue::fromBool(true));
+    Bp count;
+    count.kind = Bp::Kind::FireTransition;
+    count.index = 0;
+    t.setBreakpoints({ odd, count });
+    for (int k=0; k<4; ++k){
+        const EfsmEngine::StepResult s = t.step();
+        QCOMPARE(s.transition, 0);
+        QCOMPARE(s.breakpoint, 1);
+    }
+    t.setBreakpoints({ odd });
+    QCOMPARE(t.step().breakpoint, 0);    // n = 5
+    QCOMPARE(t.step().breakpoint, -1);   // "done": n continua ímpar
+}
+
+void EfsmCoreTests::workerResumesAfterCondition(){
+    const EfsmModel m = counterModel();
+    EfsmEngine e(m);
+    e.setInput(0, EfsmValue::fromBool(true));
+    EfsmEngine::Breakpoint bp;
+    bp.condition = "n >= 2";
+
+    EfsmWorker w;
+    QSignalSpy finished(&w, &EfsmWorker::finished);
+    QVERIFY(w.start(m, EfsmCheckpoint::capture(e), EfsmEngine::RunLimits(), { bp }));
+    EfsmWorker::Result r = waitWorker(w, finished);
+    QCOMPARE(r.run.breakpoint, 0);
+    QCOMPARE(r.run.steps, qint64(2));
+
+    // retomar de onde parou: a condição continua verdadeira, não para de novo
+    QVERIFY(w.start(m, r.final, EfsmEngine::RunLimits(), { bp }));
+    r = waitWorker(w, finished);
+    QCOMPARE(r.run.breakpoint, -1);
+    QVERIFY(r.run.reachedFinal);
+    QCOMPARE(r.run.steps, qint64(4));   // n = 3, 4, 5 e "done"
+    QVERIFY(!r.cancelled);
+}
+
+void EfsmCoreTests::workerCancel(){
+    const EfsmModel m = loopModel();
+    EfsmWorker w;
+    QSignalSpy progress(&w, &EfsmWorker::progress);
+    QSignalSpy finished(&w, &EfsmWorker::finished);
+    QVERIFY(w.start(m, EfsmCheckpoint::capture(EfsmEngine(m)), EfsmEngine::RunLimits()));
+    QVERIFY(!w.start(m, EfsmCheckpoint::capture(EfsmEngine(m)), EfsmEngine::RunLimits()));   // ocupado
+    QTRY_VERIFY_WITH_TIMEOUT(progress.count() > 0, 5000);
+    w.cancel();
+    const EfsmWorker::Result r = waitWorker(w, finished);
+    QVERIFY(r.cancelled);
+    QVERIFY(!r.timedOut);
+    QVERIFY(r.run.steps > 0);
+    QCOMPARE(r.final.steps, r.run.steps);
+}
+
+void EfsmCoreTests::workerWatchdogTimeout(){
+#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
+    QSKIP("QJSEngine::setInterrupted requer Qt 5.14");
+#endif
+    const EfsmModel m = loopModel("while (true) {}");
+    EfsmWorker w;
+    w.setScriptTimeout(100);
+    QSignalSpy finished(&w, &EfsmWorker::finished);
+    QElapsedTimer clock;
+    clock.start();
+    QVERIFY(w.start(m, EfsmCheckpoint::capture(EfsmEngine(m)), EfsmEngine::RunLimits()));
+    const EfsmWorker::Result r = waitWorker(w, finished);
+    QVERIFY(r.timedOut);
+    QVERIFY(!r.cancelled);
+    QCOMPARE(r.run.status, EfsmEngine::StepStatus::ActionError);
+    QCOMPARE(r.run.steps, qint64(0));
+    QVERIFY(clock.elapsed() < 4000);
+}
+
+void EfsmCoreTests::codegenMatchesEngine(){
+    const EfsmModel model = codegenFixture();
+    QCOMPARE(model.transitions.size(), 5);
+    EfsmCodegen::Report report;
+    EfsmCodegen::toCpp(model, EfsmCodegen::Options(), &report);
+    QVERIFY(report.untranslated.isEmpty());
+
+    fixture::Machine m;
+    EfsmEngine e(model);
+    const qint64 big = qint64(1) << 30;
+    // && / || devolvem o operando, % com dividendo negativo, === entre bool e
+    // int (t0 nunca dispara), um passo sem guarda verdadeira
+    compareCodegenStep(m, e, 1,  3, false, 1);
+    compareCodegenStep(m, e, 1,  0, true,  1);
+    compareCodegenStep(m, e, 1,  0, false, -1);
+    compareCodegenStep(m, e, 2,  0, false, 2);
+    compareCodegenStep(m, e, 0,  0, false, 4);
+    compareCodegenStep(m, e, 3, -5, false, 3);
+    compareCodegenStep(m, e, 1,  2, false, 1);
+    compareCodegenStep(m, e, 3, big, false, 3);
+    QCOMPARE(qint64(m.x.a), qint64(-1));
+    QCOMPARE(qint64(m.x.r), qint64(-19));
+    QCOMPARE(qint64(m.out.o), qint64(2));
+    QVERIFY(m.x.e);
+
+    // n * k passa de 2^53: o engine cai para o JS, o gerado para sem mudar nada
+    const fixture::Machine before = m;
+    m.in.k = big;
+    e.setInput(1, EfsmValue::fromInt(big));
+    const fixture::StepResult g = fixture::step(m);
+    QCOMPARE(g.status, fixture::Status::Overflow);
+    QCOMPARE(g.transition, 3);
+    QCOMPARE(qint64(m.x.n), qint64(before.x.n));
+    QCOMPARE(qint64(m.steps), qint64(before.steps));
+    const EfsmEngine::StepResult r = e.step();
+    QCOMPARE(r.status, EfsmEngine::StepStatus::Fired);
+    QCOMPARE(r.transition, 3);
+}
+
+void EfsmCoreTests::codegenOverflowAtSafeLimit(){
+    const EfsmModel model = codegenFixture();
+    const qint64 maxSafe = qint64(1) << 53;
+    {   // n + k == 2^53: ainda exato nos dois
+        fixture::Machine m;
+        EfsmEngine e(model);
+        compareCodegenStep(m, e, 1, maxSafe - 1, false, 1);
+        QCOMPARE(qint64(m.x.n), maxSafe);
+    }
+    // n + k == 2^53 + 1, e depois um input já fora da faixa
+    for (qint64 k : { maxSafe, maxSafe + 1 }){
+        fixture::Machine m;
+        m.in.op = 1;
+        m.in.k = k;
+        const fixture::StepResult g = fixture::step(m);
+        QCOMPARE(g.status, fixture::Status::Overflow);
+        QCOMPARE(g.transition, 1);
+        QCOMPARE(qint64(m.x.n), qint64(1));
+        QCOMPARE(qint64(m.steps), qint64(0));
+    }
+}
+
+QTEST_GUILESS_MAIN(EfsmCoreTests)
+#include "EfsmCoreTests.moc"
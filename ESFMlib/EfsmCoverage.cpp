@@ -0,0 +1,237 @@
+#include "EfsmCoverage.h"
+#include "EfsmConfig.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <QIODevice>
+#include <QJsonObject>
+#include <algorithm>
+#include <deque>
+#include <queue>
+
+namespace {
+
+// nó da árvore de busca: como a configuração foi alcançada pela primeira vez
+struct Node {
+    int parent = -1;
+    qint64 combo = -1;      // combinação de inputs aplicada no pai
+    int transition = -1;    // transição disparada
+};
+
+// candidato na fila da cobertura gulosa: maior ganho primeiro, depois o
+// caminho mais curto, depois o menor índice
+struct CoverEntry {
+    int gain;
+    int rows;
+    int index;
+    bool operator<(const CoverEntry& o) const {
+        if (gain != o.gain) return gain < o.gain;
+        if (rows != o.rows) return rows > o.rows;
+        return index > o.index;
+    }
+};
+
+QString csvCell(const QString& s){
+    if (!s.contains(',') && !s.contains('"')) return s;
+    QString q = s;
+    q.replace("\"", "\"\"");
+    return '"' + q + '"';
+}
+
+} // namespace
+
+EfsmCoverage::Suite EfsmCoverage::generate(const EfsmModel& model,
+                                           const EfsmExplorer::Options& options,
+                                           const std::atomic<bool>* cancel){
+    Suite suite;
+    QElapsedTimer clock;
+    clock.start();
+    const int nt = model.transitions.size();
+    suite.covered.fill(false, nt);
+
+    const int init = model.initialState();
+    if (init < 0 || nt == 0) { suite.elapsedMs = clock.elapsed(); return suite; }
+
+    // inputs do domínio -> índices em I
+    QVector<int> domIdx;
+    QVector<QVector<EfsmValue>> domVals;
+    for (const auto& d : options.inputs){
+        for (int k=0; k<model.inputs.size(); ++k)
+            if (model.inputs[k].name == d.name) {
+                domIdx.push_back(k); domVals.push_back(d.values); suite.inputs << d.name;
+                break;
+            }
+    }
+    // combinação (índice misto, domínio 0 é o dígito menos significativo) -> linha
+    auto rowOf = [&domVals](qint64 combo){
+        QVector<EfsmValue> row;
+        row.reserve(domVals.size());
+        for (const auto& vals : domVals) { row.push_back(vals[combo % vals.size()]); combo /= vals.size(); }
+        return row;
+    };
+
+    EfsmEngine e(model);
+    QVector<Node> nodes;
+    QHash<quint64, int> seen;                       // impressão digital -> nó
+    std::deque<QPair<int, QByteArray>> frontier;    // (nó, configuração)
+    QVector<QPair<int, qint64>> witness(nt, qMakePair(-1, qint64(-1)));   // (nó, combinação)
+    int remaining = nt;
+
+    {
+        QByteArray c = EfsmConfig::encode(e, true);
+        seen.insert(EfsmConfig::fingerprint(c), 0);
+        nodes.push_back(Node());
+        frontier.push_back(qMakePair(0, c));
+    }
+
+    QVector<int> odo(domIdx.size());
+    while (!frontier.empty() && remaining > 0){
+        if (nodes.size() >= options.maxConfigurations || (cancel && cancel->load())){
+            suite.complete = false;
+            break;
+        }
+        const int id = frontier.front().first;
+        const QByteArray c = std::move(frontier.front().second);
+        frontier.pop_front();
+
+        // a configuração só é recarregada depois de um passo que a alterou
+        // (guardas não escrevem; ActionError não muda nada)
+        bool loaded = false;
+        odo.fill(0);
+        for (qint64 combo = 0; ; ++combo){
+            if (!loaded) { EfsmConfig::load(e, c, true); loaded = true; }
+            for (int d=0; d<domIdx.size(); ++d) e.setInput(domIdx[d], domVals[d][odo[d]]);
+
+            const EfsmEngine::StepResult r = e.step();
+            if (r.status == EfsmEngine::StepStatus::Fired){
+                loaded = false;
+                const int t = r.transition;
+                if (!suite.covered[t]){
+                    suite.covered[t] = true;
+                    witness[t] = qMakePair(id, combo);
+                    if (--remaining == 0) break;
+                }
+                QByteArray next = EfsmConfig::encode(e, true);
+                const quint64 fp = EfsmConfig::fingerprint(next);
+                if (!seen.contains(fp)){
+                    seen.insert(fp, nodes.size());
+                    nodes.push_back({ id, combo, t });
+                    frontier.push_back(qMakePair(nodes.size() - 1, std::move(next)));
+                }
+            }
+
+            int d = 0;
+            for (; d<odo.size(); ++d){
+                if (++odo[d] < domVals[d].size()) break;
+                odo[d] = 0;
+            }
+            if (d == odo.size()) break;   // deu a volta
+        }
+    }
+    suite.configurations = nodes.size();
+
+    // um candidato por transição coberta: caminho até o nó + o passo final
+    QVector<Test> candidates;
+    for (int t=0; t<nt; ++t){
+        if (witness[t].first < 0) continue;
+        Test test;
+        test.rows.push_back(rowOf(witness[t].second));
+        test.transitions.push_back(t);
+        for (int n = witness[t].first; nodes[n].parent >= 0; n = nodes[n].parent){
+            test.rows.push_back(rowOf(nodes[n].combo));
+            test.transitions.push_back(nodes[n].transition);
+        }
+        std::reverse(test.rows.begin(), test.rows.end());
+        std::reverse(test.transitions.begin(), test.transitions.end());
+        candidates.push_back(test);
+    }
+
+    // cobertura de conjuntos gulosa, preguiçosa: o ganho de um candidato só
+    // diminui à medida que transições são cobertas, então o da fila é um teto.
+    // Reavalia só o topo; se o ganho não mudou, nenhum outro o supera. Mesma
+    // escolha da versão ingênua (maior ganho; empate = mais curto, depois o
+    // de menor índice) sem recontar todos os candidatos a cada rodada.
+    QVector<QVector<int>> sets(candidates.size());   // transições distintas de cada um
+    std::priority_queue<CoverEntry> heap;
+    for (int i=0; i<candidates.size(); ++i){
+        QVector<int>& set = sets[i];
+        set = candidates[i].transitions;
+        std::sort(set.begin(), set.end());
+        set.erase(std::unique(set.begin(), set.end()), set.end());
+        heap.push({ int(set.size()), int(candidates[i].rows.size()), i });
+    }
+    QVector<bool> need = suite.covered;
+    while (!heap.empty()){
+        CoverEntry top = heap.top();
+        heap.pop();
+        int gain = 0;
+        for (int t : sets[top.index]) gain += need[t];
+        if (gain == 0) continue;
+        if (gain < top.gain) { top.gain = gain; heap.push(top); continue; }
+        for (int t : sets[top.index]) need[t] = false;
+        suite.tests.push_back(candidates[top.index]);
+    }
+
+    suite.elapsedMs = clock.elapsed();
+    return suite;
+}
+
+bool EfsmCoverage::writeCsv(const Suite& suite, const Test& test, QIODevice& out){
+    QStringList header;
+    for (const auto& name : suite.inputs) header << csvCell(name);
+    QByteArray text = header.join(',').toUtf8() + '\n';
+    for (const auto& row : test.rows){
+        QStringList cells;
+        for (const auto& v : row) cells << csvCell(v.toString());
+        text += cells.join(',').toUtf8() + '\n';
+    }
+    return out.write(text) == text.size();
+}
+
+QJsonArray EfsmCoverage::toScenarios(const Suite& suite){
+    QJsonArray arr;
+    for (int i=0; i<suite.tests.size(); ++i){
+        const Test& test = suite.tests[i];
+        QJsonArray trace;
+        for (const auto& row : test.rows){
+            QJsonObject o;
+            for (int d=0; d<row.size(); ++d) o[suite.inputs[d]] = EfsmModel::encodeJsonValue(row[d]);
+            trace.push_back(o);
+        }
+        QJsonObject sc;
+        sc["name"] = QString("test_%1").arg(i+1, 3, 10, QChar('0'));
+        sc["trace"] = trace;
+        sc["maxSteps"] = test.rows.size();
+        arr.push_back(sc);
+    }
+    return arr;
+}
+
+QString EfsmCoverage::Suite::summary(const EfsmModel& model) const {
+    QStringList lines;
+    int steps = 0;
+    for (const auto& t : tests) steps += t.rows.size();
+    lines << QString("%1 testes, %2 passos no total (%3 configurações em %4 ms)%5")
+                 .arg(tests.size()).arg(steps).arg(configurations).arg(elapsedMs)
+                 .arg(complete ? QString() : QString(" — INCOMPLETA (limite/cancelada)"));
+    lines << QString("Transições cobertas: %1 de %2").arg(covered.count(true)).arg(covered.size());
+
+    QStringList missing;
+    for (int i=0; i<covered.size(); ++i){
+        if (covered[i]) continue;
+        const auto& t = model.transitions[i];
+        missing << QString("%1 → %2 [%3]").arg(model.states[t.from].name, model.states[t.to].name, t.guard);
+    }
+    if (!missing.isEmpty()){
+        lines << (complete ? QString("Não disparáveis com este domínio:")
+                           : QString("Não cobertas:"));
+        for (const auto& m : missing) lines << "  " + m;
+    }
+    for (int i=0; i<tests.size(); ++i){
+        QStringList ts;
+        for (int t : tests[i].transitions)
+            ts << model.states[model.transitions[t].from].name + "→" + model.states[model.transitions[t].to].name;
+        lines << QString("test_%1 (%2 passos): %3").arg(i+1, 3, 10, QChar('0'))
+                     .arg(tests[i].rows.size()).arg(ts.join(", "));
+    }
+    return lines.join('\n');
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "EfsmExplorer.h"
+#include <QJsonArray>
+#include <QStringList>
+
+class QIODevice;
+
+// Geração de testes por cobertura de transições: a partir do estado
+// inicial, procura sequências de inputs (do domínio finito de
+// EfsmExplorer::Options) que juntas disparem todas as transições
+// alcançáveis, com o menor número de testes que a heurística consegue.
+//
+// Uma única busca em largura serve a todos os alvos: a primeira vez que
+// uma transição dispara dá o caminho mais curto até ela (pais guardados
+// por configuração, deduplicada por impressão digital) e a busca para assim
+// que não resta transição descoberta. Os caminhos candidatos passam por
+// uma cobertura de conjuntos gulosa (o que cobre mais transições ainda
+// descobertas; empate = o mais curto), avaliada de forma preguiçosa numa
+// fila de prioridade: O(soma dos caminhos · log) em vez de recontar todos
+// os candidatos a cada teste escolhido.
+class EfsmCoverage {
+public:
+    struct Test {
+        QVector<QVector<EfsmValue>> rows;   // por passo: um valor por input do domínio
+        QVector<int> transitions;           // disparadas, na ordem
+    };
+
+    struct Suite {
+        QStringList inputs;                 // colunas de rows (nomes em model.inputs)
+        QVector<Test> tests;
+        QVector<bool> covered;              // por índice de model.transitions
+        qint64 configurations = 0;
+        bool complete = true;               // false: limite de configurações ou cancelada
+        qint64 elapsedMs = 0;
+        QString summary(const EfsmModel& model) const;
+    };
+
+    // options.threads é ignorado (busca sequencial: os caminhos dependem da
+    // ordem); O sempre entra na configuração para o teste reproduzir igual
+    static Suite generate(const EfsmModel& model, const EfsmExplorer::Options& options,
+                          const std::atomic<bool>* cancel = nullptr);
+
+    // CSV com cabeçalho = nomes dos inputs, lido por EfsmReplay
+    static bool writeCsv(const Suite& suite, const Test& test, QIODevice& out);
+    // cenários no formato de EfsmBatch::scenariosFromJson
+    static QJsonArray toScenarios(const Suite& suite);
+};
@@ -0,0 +1,555 @@
+#include "EfsmEngine.h"
+#include "EfsmHistory.h"
+#include <QtQml/QJSEngine>
+#include <QtQml/QJSValue>
+#include <QElapsedTimer>
+#include <QRegularExpression>
+#include <QVarLengthArray>
+#include <chrono>
+#include <cmath>        // std::llround
+
+namespace {
+
+// ação com declaração própria (var x = …, function f(){…}): dentro de uma
+// função o nome ficaria local; no evaluate() ele vira global da sessão e
+// persiste entre passos, que é o comportamento do script solto
+bool declaresNames(const QString& src){
+    static const QRegularExpression re(QStringLiteral("\\b(var|let|const|function|class)\\b"));
+    return re.match(src).hasMatch();
+}
+
+qint64 nowNs(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+EfsmEngine::EfsmEngine() = default;
+
+EfsmEngine::EfsmEngine(const EfsmModel& model){
+    setModel(model);
+}
+
+EfsmEngine::~EfsmEngine() = default;
+
+void EfsmEngine::setModel(const EfsmModel& model){
+    model_ = model;
+    model_.rebuildIndex();
+
+    // nomes -> slots do VM (X | I | O); nome repetido entre conjuntos fica
+    // ambíguo (-1) e os scripts que o usam ficam no JS
+    slotOf_.clear();
+    slotName_.clear();
+    nx_ = model_.vars.size();
+    ni_ = model_.inputs.size();
+    no_ = model_.outputs.size();
+    for (const QVector<EfsmVar>* decl : { &model_.vars, &model_.inputs, &model_.outputs }){
+        for (const auto& v : *decl){
+            auto it = slotOf_.find(v.name);
+            if (it == slotOf_.end()) slotOf_.insert(v.name, slotName_.size());
+            else it.value() = -1;
+            slotName_.push_back(v.name);
+        }
+    }
+
+    clearScripts();      // nomes/slots podem ter mudado
+    breakpoints_.clear();
+    indexBreakpoints();
+    resetSession();
+    resetProfile();
+    reset();
+}
+
+void EfsmEngine::resetProfile(){
+    profile_.fill(TransitionProfile(), model_.transitions.size());
+    stateEntries_.fill(0, model_.states.size());
+}
+
+void EfsmEngine::addProfile(const QVector<TransitionProfile>& transitions, const QVector<qint64>& states){
+    if (transitions.size() != profile_.size() || states.size() != stateEntries_.size()) return;
+    for (int i=0; i<profile_.size(); ++i){
+        profile_[i].guardEvals += transitions[i].guardEvals;
+        profile_[i].guardNs    += transitions[i].guardNs;
+        profile_[i].fires      += transitions[i].fires;
+        profile_[i].actionNs   += transitions[i].actionNs;
+    }
+    for (int i=0; i<stateEntries_.size(); ++i) stateEntries_[i] += states[i];
+}
+
+void EfsmEngine::clearScripts(){
+    scripts_.clear();
+    scriptIndex_.clear();
+    guardFn_.fill(-1, model_.transitions.size());
+    actionFn_.fill(-1, model_.transitions.size());
+    watchFn_.fill(-1, watches_.size());
+    for (auto& c : bpConditions_) c.script = -1;
+}
+
+void EfsmEngine::resetSession(){
+    // funções JS pertencem ao engine antigo; o bytecode do VM continua válido
+    for (auto& cs : scripts_){
+        cs.fn = QJSValue();
+        cs.jsReady = cs.callable = false;
+    }
+    global_ = QJSValue();
+    {
+        std::lock_guard<std::mutex> lock(jsMutex_);
+        js_.reset();
+    }
+    anyStale_ = true;
+}
+
+void EfsmEngine::setGuard(int transition, const QString& guard){
+    if (transition < 0 || transition >= model_.transitions.size()) return;
+    model_.transitions[transition].guard = guard;
+    guardFn_[transition] = -1;
+}
+
+void EfsmEngine::setAction(int transition, const QString& action){
+    if (transition < 0 || transition >= model_.transitions.size()) return;
+    model_.transitions[transition].action = action;
+    actionFn_[transition] = -1;
+}
+
+int EfsmEngine::addTransition(const EfsmTransition& t){
+    guardFn_.push_back(-1);
+    actionFn_.push_back(-1);
+    profile_.push_back(TransitionProfile());
+    bpTransition_.push_back(-1);
+    return model_.addTransition(t);
+}
+
+void EfsmEngine::removeTransition(int transition){
+    if (transition < 0 || transition >= model_.transitions.size()) return;
+    const int last = model_.transitions.size() - 1;
+    model_.removeTransition(transition);
+    guardFn_[transition]  = guardFn_.back();
+    actionFn_[transition] = actionFn_.back();
+    guardFn_.pop_back();
+    actionFn_.pop_back();
+    profile_[transition] = profile_.back();
+    profile_.pop_back();
+
+    // breakpoints na transição removida somem; os da última seguem o índice
+    bool moved = false;
+    for (int i = breakpoints_.size()-1; i >= 0; --i){
+        Breakpoint& b = breakpoints_[i];
+        if (b.kind != Breakpoint::Kind::FireTransition) continue;
+        if (b.index == transition) { breakpoints_.remove(i); moved = true; }
+        else if (b.index == last)  { b.index = transition; moved = true; }
+    }
+    if (moved) indexBreakpoints();
+    else       bpTransition_.pop_back();   // todas -1 nesta faixa
+}
+
+void EfsmEngine::setPriority(int transition, int priority){
+    model_.setTransitionPriority(transition, priority);
+}
+
+void EfsmEngine::setStateInfo(int state, const QString& name, bool initial, bool final){
+    if (state < 0 || state >= model_.states.size()) return;
+    EfsmState& s = model_.states[state];
+    s.name = name;
+    s.initial = initial;
+    s.final = final;
+}
+
+void EfsmEngine::setBreakpoints(const QVector<Breakpoint>& breakpoints){
+    breakpoints_ = breakpoints;
+    indexBreakpoints();
+}
+
+void EfsmEngine::indexBreakpoints(){
+    bpState_.fill(-1, model_.states.size());
+    bpTransition_.fill(-1, model_.transitions.size());
+    bpConditions_.clear();
+    for (int i=0; i<breakpoints_.size(); ++i){
+        const Breakpoint& b = breakpoints_[i];
+        switch (b.kind){
+        case Breakpoint::Kind::EnterState:
+            if (b.index >= 0 && b.index < bpState_.size() && bpState_[b.index] < 0) bpState_[b.index] = i;
+            break;
+        case Breakpoint::Kind::FireTransition:
+            if (b.index >= 0 && b.index < bpTransition_.size() && bpTransition_[b.index] < 0) bpTransition_[b.index] = i;
+            break;
+        case Breakpoint::Kind::Condition:
+            bpConditions_.push_back({ i });
+            break;
+        }
+    }
+}
+
+int EfsmEngine::checkBreakpoints(int transition){
+    int hit = bpTransition_[transition];
+    if (hit < 0) hit = bpState_[current_];
+    // todas as condições são vistas para manter "last" em dia; o memo das
+    // guardas evita reavaliar as que não leem nada que mudou
+    for (auto& c : bpConditions_){
+        const bool v = evalCondition(c);
+        if (v && !c.last && hit < 0) hit = c.breakpoint;
+        c.last = v;
+    }
+    return hit;
+}
+
+void EfsmEngine::primeConditions(){
+    for (auto& c : bpConditions_) c.last = evalCondition(c);
+}
+
+bool EfsmEngine::evalCondition(ConditionBp& c){
+    if (c.script < 0) c.script = compile(breakpoints_[c.breakpoint].condition, ScriptKind::Guard);
+    bool v = false;
+    QString err;
+    return evalGuard(c.script, v, err) && v;
+}
+
+void EfsmEngine::setWatches(const QStringList& expressions){
+    watches_ = expressions;
+    watchFn_.fill(-1, watches_.size());
+}
+
+QVector<EfsmValue> EfsmEngine::watchValues(QStringList* errors){
+    QVector<EfsmValue> out(watches_.size());
+    if (errors) errors->clear();
+    for (int k=0; k<watches_.size(); ++k){
+        int& fn = watchFn_[k];
+        if (fn < 0) fn = compile(watches_[k], ScriptKind::Guard);
+        CompiledScript& cs = scripts_[fn];
+        QString err;
+        if (!(cs.vm.valid && EfsmVm::run(cs.vm, slots_.data(), &out[k]) == EfsmVm::Result::Ok)){
+            const QJSValue v = runJs(cs);
+            if (v.isError()) err = v.toString();
+            else             out[k] = fromJsValue(v);
+        }
+        if (errors) errors->push_back(err);
+    }
+    return out;
+}
+
+int EfsmEngine::compile(const QString& text, ScriptKind kind){
+    // normaliza: guarda vazia = true; ";" finais não fazem parte da expressão
+    QString src = text.trimmed();
+    if (kind == ScriptKind::Action) src.replace(":=", "=");   // ":=" -> "=" para o JS
+    while (src.endsWith(';')) src.chop(1);
+    if (kind == ScriptKind::Guard && src.trimmed().isEmpty()) src = "true";
+
+    const QString key = (kind == ScriptKind::Guard ? QStringLiteral("g:") : QStringLiteral("a:")) + src;
+    const auto it = scriptIndex_.constFind(key);
+    if (it != scriptIndex_.constEnd()) return it.value();
+
+    CompiledScript cs;
+    cs.source = src;
+    cs.kind = kind;
+    const EfsmVm::Resolver resolve = [this](const QString& name, bool forWrite){
+        const int slot = slotOf_.value(name, -1);
+        if (forWrite && slot >= nx_ && slot < nx_ + ni_)
+            return -1;   // ações não escrevem inputs
+        return slot;
+    };
+    if (!src.isEmpty()){
+        if (kind == ScriptKind::Guard) EfsmVm::compileGuard(src, resolve, cs.vm);
+        else                           EfsmVm::compileAction(src, resolve, cs.vm);
+    }
+    if (kind == ScriptKind::Guard){
+        if (cs.vm.valid) { cs.reads = cs.vm.reads; cs.memoizable = true; }
+        else cs.memoizable = EfsmVm::readSet(src, resolve, cs.reads);
+    }
+    scripts_.push_back(cs);
+    scriptIndex_.insert(key, scripts_.size()-1);
+    return scripts_.size()-1;
+}
+
+QJSValue EfsmEngine::runJs(CompiledScript& cs){
+    syncToJs();   // o VM pode ter deixado globais desatualizados
+    if (!cs.jsReady){
+        if (cs.kind == ScriptKind::Guard || !declaresNames(cs.source)){
+            const QString wrapped = (cs.kind == ScriptKind::Guard)
+                ? QStringLiteral("(function(){ return (\n%1\n); })").arg(cs.source)
+                : QStringLiteral("(function(){\n%1\n})").arg(cs.source);
+            const QJSValue fn = js_->evaluate(wrapped);
+            // não coube numa função (ex.: várias instruções numa guarda):
+            // fica o evaluate() por chamada, como antes
+            cs.callable = !fn.isError() && fn.isCallable();
+            if (cs.callable) cs.fn = fn;
+        }
+        cs.jsReady = true;
+    }
+    // jsSince_ e interrupted_ só mudam sob jsMutex_: uma interrupção ou cai
+    // dentro desta chamada ou é descartada (interruptScript vê jsSince_ == 0)
+    {
+        std::lock_guard<std::mutex> lock(jsMutex_);
+        interrupted_ = false;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        js_->setInterrupted(false);
+#endif
+        jsSince_.store(nowNs(), std::memory_order_relaxed);
+    }
+    QJSValue v = cs.callable ? cs.fn.call() : js_->evaluate(cs.source);
+    bool interrupted = false;
+    {
+        std::lock_guard<std::mutex> lock(jsMutex_);
+        jsSince_.store(0, std::memory_order_relaxed);
+        interrupted = interrupted_.exchange(false);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+        if (interrupted) js_->setInterrupted(false);
+#endif
+    }
+    // a interrupção pode ter chegado depois do fim: só troca um erro
+    if (interrupted && v.isError()) v = js_->newErrorObject(QJSValue::GenericError, "script interrompido pelo watchdog");
+    return v;
+}
+
+qint64 EfsmEngine::scriptElapsedNs() const {
+    const qint64 since = jsSince_.load(std::memory_order_relaxed);
+    return since ? nowNs() - since : 0;
+}
+
+void EfsmEngine::interruptScript(){
+    std::lock_guard<std::mutex> lock(jsMutex_);
+    if (!js_ || !jsSince_.load()) return;
+    interrupted_ = true;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 14, 0)
+    js_->setInterrupted(true);
+#endif
+}
+
+bool EfsmEngine::evalGuard(int script, bool& value, QString& error){
+    CompiledScript& cs = scripts_[script];
+    if (cs.memoValid){
+        bool fresh = true;
+        for (int slot : cs.reads)
+            if (slotEpoch_[slot] > cs.memoEpoch) { fresh = false; break; }
+        if (fresh) { value = cs.memoValue; ++guardStats_.cached; return true; }
+    }
+    ++guardStats_.evaluated;
+
+    EfsmValue res;
+    if (cs.vm.valid && EfsmVm::run(cs.vm, slots_.data(), &res) == EfsmVm::Result::Ok){
+        value = res.truthy();
+    } else {
+        const QJSValue v = runJs(cs);
+        if (v.isError()) { cs.memoValid = false; error = v.toString(); return false; }
+        bool ok = false;
+        value = jsToBool(v, ok) && ok;
+    }
+    if (cs.memoizable){
+        cs.memoValue = value;
+        cs.memoEpoch = epoch_;
+        cs.memoValid = true;
+    }
+    return true;
+}
+
+void EfsmEngine::reset(){
+    current_ = model_.initialState();
+    steps_ = 0;
+    slots_.clear();
+    slots_.reserve(nx_ + ni_ + no_);
+    for (const QVector<EfsmVar>* decl : { &model_.vars, &model_.inputs, &model_.outputs })
+        for (const auto& v : *decl) slots_.push_back(v.value);
+    slotEpoch_.fill(++epoch_, slots_.size());   // invalida todos os memos
+    markAllStale();
+    if (history_) history_->clear();
+}
+
+void EfsmEngine::assign(int slot, const EfsmValue& v){
+    if (slots_[slot] == v) return;
+    slots_[slot] = v;
+    touch(slot);
+    stale_[slot] = true;
+    anyStale_ = true;
+    if (history_ && slot < nx_)         history_->noteEdit(slot);
+    if (history_ && slot >= nx_ + ni_)  history_->noteEdit(slot - ni_);
+}
+
+void EfsmEngine::markChanged(int slot, StepResult& r){
+    touch(slot);
+    stale_[slot] = true;
+    anyStale_ = true;
+    if (slot < nx_) r.changedVars.push_back(slot);
+    else            r.changedOutputs.push_back(slot - nx_ - ni_);   // ações não escrevem I
+}
+
+void EfsmEngine::markAllStale(){
+    stale_.fill(true, slots_.size());
+    anyStale_ = true;
+}
+
+void EfsmEngine::syncToJs(){
+    if (!js_){
+        std::lock_guard<std::mutex> lock(jsMutex_);
+        js_ = std::make_unique<QJSEngine>();
+        global_ = js_->globalObject();
+        markAllStale();
+    }
+    if (!anyStale_) return;
+
+    // X, I e O (O disponível para leitura e passível de escrita pela ação)
+    for (int k=0; k<slots_.size(); ++k){
+        if (!stale_[k]) continue;
+        global_.setProperty(slotName_[k], toJsValue(slots_[k]));
+        stale_[k] = false;
+    }
+    anyStale_ = false;
+}
+
+QJSValue EfsmEngine::toJsValue(const EfsmValue& v){
+    switch (v.type){
+    case EfsmValue::Bool: return QJSValue(v.i != 0);
+    case EfsmValue::Int:  return QJSValue((double)v.i);
+    default:              return QJSValue(v.s);
+    }
+}
+
+EfsmValue EfsmEngine::fromJsValue(const QJSValue& v){
+    if (v.isBool())   return EfsmValue::fromBool(v.toBool());
+    if (v.isNumber()) return EfsmValue::fromInt(std::llround(v.toNumber()));
+    return EfsmValue::parse(v.toString());
+}
+
+bool EfsmEngine::jsToBool(const QJSValue& v, bool& ok){
+    ok = true;
+    if (v.isBool())   return v.toBool();
+    if (v.isNumber()) return v.toNumber()!=0.0;
+    if (v.isString()){
+        const auto s = v.toString().trimmed();
+        if (s.compare("true", Qt::CaseInsensitive)==0)  return true;
+        if (s.compare("false", Qt::CaseInsensitive)==0) return false;
+    }
+    ok = false; return false;
+}
+
+EfsmEngine::StepResult EfsmEngine::step(){
+    StepResult r;
+    stepInto(r);
+    return r;
+}
+
+EfsmEngine::RunResult EfsmEngine::run(const RunLimits& limits){
+    RunResult out;
+    if (limits.stopAtFinal && isFinal()) { out.reachedFinal = true; return out; }
+
+    QElapsedTimer clock;
+    clock.start();
+    QVector<bool> varSeen(nx_, false), outSeen(no_, false);
+    StepResult r;
+    while (limits.maxSteps < 0 || out.steps < limits.maxSteps){
+        r.status = StepStatus::NoCurrentState;
+        r.transition = -1;
+        r.breakpoint = -1;
+        r.changedVars.resize(0);      // mantém a capacidade entre passos
+        r.changedOutputs.resize(0);
+        stepInto(r);
+
+        out.status = r.status;
+        if (r.transition >= 0) out.transition = r.transition;
+        if (r.status != StepStatus::Fired) { out.error = r.error; break; }
+        ++out.steps;
+        for (int k : r.changedVars)
+            if (!varSeen[k]) { varSeen[k] = true; out.changedVars.push_back(k); }
+        for (int k : r.changedOutputs)
+            if (!outSeen[k]) { outSeen[k] = true; out.changedOutputs.push_back(k); }
+        if (r.breakpoint >= 0) { out.breakpoint = r.breakpoint; break; }
+
+        if (limits.stopAtFinal && isFinal()) { out.reachedFinal = true; break; }
+        if (limits.cancel && limits.cancel->load(std::memory_order_relaxed)) break;
+        // relógio a cada 64 passos: barato e ainda fino o bastante para a GUI
+        if (limits.maxMillis >= 0 && (out.steps & 63) == 0 && clock.elapsed() >= limits.maxMillis) break;
+    }
+    out.guardError = r.guardError;
+    return out;
+}
+
+void EfsmEngine::stepInto(StepResult& r){
+    if (current_ < 0 || current_ >= model_.states.size()) {
+        r.status = StepStatus::NoCurrentState;
+        return;
+    }
+    if (history_ && history_->isEmpty()) history_->start(*this);   // quadro do passo 0
+
+    // 1) Candidatas já em ordem (prioridade, id): a primeira guarda g(X,I)
+    //    verdadeira decide, as demais nem são avaliadas
+    const QVector<int>& out = model_.outgoing(current_);
+    if (out.isEmpty()) { r.status = StepStatus::NoOutgoing; return; }
+
+    int chosen = -1;
+    for (int ti : out){
+        int& fn = guardFn_[ti];
+        if (fn < 0) fn = compile(model_.transitions[ti].guard, ScriptKind::Guard);
+        bool b = false;
+        QString err;
+        bool ok;
+        if (profiling_){
+            const qint64 t0 = nowNs();
+            ok = evalGuard(fn, b, err);
+            TransitionProfile& p = profile_[ti];
+            ++p.guardEvals;
+            p.guardNs += nowNs() - t0;
+        } else {
+            ok = evalGuard(fn, b, err);
+        }
+        if (!ok) {   // guarda inválida => trata como false
+            r.guardError = err;
+            continue;
+        }
+        if (b) { chosen = ti; break; }
+    }
+    if (chosen < 0) { r.status = StepStatus::NoneEnabled; return; }
+    const EfsmTransition& t = model_.transitions[chosen];
+
+    // 2) Ação a(X,I,O)
+    const qint64 a0 = profiling_ ? nowNs() : 0;
+    int& act = actionFn_[chosen];
+    if (act < 0) act = compile(t.action, ScriptKind::Action);
+    CompiledScript& cs = scripts_[act];
+    bool native = false;
+    if (cs.vm.valid){
+        // o VM escreve direto nos slots: guarda os valores anteriores para
+        // saber o que de fato mudou
+        QVarLengthArray<EfsmValue, 8> before;
+        for (int slot : cs.vm.writes) before.append(slots_[slot]);
+        if (EfsmVm::run(cs.vm, slots_.data()) == EfsmVm::Result::Ok){
+            for (int k=0; k<cs.vm.writes.size(); ++k)
+                if (slots_[cs.vm.writes[k]] != before[k]) markChanged(cs.vm.writes[k], r);
+            native = true;
+        }
+    }
+    if (!native && !cs.source.isEmpty()){
+        const QJSValue res = runJs(cs);
+        if (res.isError()){
+            r.status = StepStatus::ActionError;
+            r.transition = chosen;
+            r.error = res.toString();
+            markAllStale();           // desfaz escritas parciais da ação no JS
+            return;                   // aborta para não ficar inconsistente
+        }
+
+        // Ler de volta X e O (o global JS já está em dia); inputs não são
+        // alterados por ações, então uma escrita num input é desfeita no
+        // próximo passo.
+        for (int slot=0; slot<slots_.size(); ++slot){
+            const EfsmValue v = fromJsValue(global_.property(slotName_[slot]));
+            if (v == slots_[slot]) continue;
+            if (slot >= nx_ && slot < nx_ + ni_) { stale_[slot] = true; anyStale_ = true; continue; }
+            slots_[slot] = v;
+            touch(slot);
+            if (slot < nx_) r.changedVars.push_back(slot);
+            else            r.changedOutputs.push_back(slot - nx_ - ni_);
+        }
+    }
+
+    // 3) Avança
+    current_ = t.to;
+    r.status = StepStatus::Fired;
+    r.transition = chosen;
+    ++steps_;
+    if (profiling_){
+        TransitionProfile& p = profile_[chosen];
+        ++p.fires;
+        p.actionNs += nowNs() - a0;
+        ++stateEntries_[current_];
+    }
+    if (history_) history_->record(*this, chosen, r.changedVars, r.changedOutputs);
+    if (!breakpoints_.isEmpty()) r.breakpoint = checkBreakpoints(chosen);
+}
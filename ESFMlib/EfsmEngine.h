@@ -0,0 +1,261 @@
+#pragma once
+#include "EfsmModel.h"
+#include "EfsmVm.h"
+#include <QtQml/QJSValue>
+#include <QHash>
+#include <QStringList>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+class QJSEngine;
+class EfsmHistory;
+
+// Executor headless de um EfsmModel: mantém estado corrente e valuations
+// de X/I/O e dá um passo de cada vez. Não depende de QtWidgets.
+//
+// Sessão: um único QJSEngine vive entre os passos; só as valuations que
+// mudaram (setVar/setInput/setOutput, reset) são reenviadas aos globais JS.
+// setModel()/resetSession() descartam o engine quando a estrutura muda.
+// Guardas devem ser livres de efeitos colaterais: o que uma guarda escreve
+// nos globais não é lido de volta.
+//
+// Scripts: guardas e ações são compilados uma vez (sob demanda) e guardados
+// por transição; textos idênticos compartilham a mesma entrada. Se o texto
+// cabe no subconjunto bool/int do EfsmVm, roda em bytecode sobre os slots
+// tipados; senão (ou se o VM desistir em tempo de execução) vira função JS.
+// setGuard()/setAction() invalidam só a transição editada.
+// Ações que declaram nomes (var, function…) seguem no evaluate() por chamada,
+// para que esses nomes continuem globais da sessão, como antes.
+//
+// Memo de guardas: cada guarda tem o seu conjunto de leitura (do bytecode ou
+// de EfsmVm::readSet). Cada slot guarda a época da última escrita; se
+// nenhum slot lido mudou desde a última avaliação, o resultado anterior é
+// reaproveitado sem rodar VM nem JS. Guardas com leitura desconhecida
+// (chamadas, globais fora de X/I/O) são sempre avaliadas.
+//
+// Watchdog: scriptElapsedNs()/interruptScript() podem ser chamados de outra
+// thread (EfsmWatchdog). Um script JS interrompido falha como qualquer erro
+// JS: guarda => false, ação => ActionError. O VM não tem laços e não precisa
+// disso.
+class EfsmEngine {
+public:
+    enum class StepStatus {
+        Fired,          // transição escolhida e ação executada
+        NoCurrentState, // modelo sem estado inicial
+        NoOutgoing,     // nenhuma transição saindo do estado corrente
+        NoneEnabled,    // nenhuma guarda verdadeira
+        ActionError     // ação falhou: valuations e estado não mudam
+    };
+
+    struct StepResult {
+        StepStatus status = StepStatus::NoCurrentState;
+        int transition = -1;   // índice em model().transitions (se Fired)
+        QString error;         // mensagem da ação (ActionError)
+        QString guardError;    // última guarda inválida (tratada como false)
+        QVector<int> changedVars;    // índices de X alterados pela ação
+        QVector<int> changedOutputs; // índices de O alterados pela ação
+        int breakpoint = -1;         // índice em breakpoints() atingido neste passo
+    };
+
+    // Breakpoints: conferidos depois de cada passo disparado; run() para no
+    // primeiro atingido. Estado/transição custam uma consulta a um vetor;
+    // condições são compiladas como guardas e passam pelo mesmo memo, então
+    // só são reavaliadas quando algum slot que leem mudou. Uma condição
+    // dispara ao passar de falsa para verdadeira.
+    struct Breakpoint {
+        enum class Kind { EnterState, FireTransition, Condition };
+        Kind kind = Kind::Condition;
+        int index = -1;          // estado (EnterState) ou transição (FireTransition)
+        QString condition;       // Condition: expressão sobre X/I/O
+    };
+
+    EfsmEngine();
+    explicit EfsmEngine(const EfsmModel& model);
+    ~EfsmEngine();
+
+    // Troca a estrutura; valuations voltam às do modelo e o estado ao inicial.
+    // Breakpoints (índices da estrutura antiga) são descartados; watches ficam.
+    void setModel(const EfsmModel& model);
+    const EfsmModel& model() const { return model_; }
+    void reset();          // valuations/estado iniciais (mantém a sessão JS)
+    // histórico de passos (opcional, não é do engine): limpo por setModel()/reset()
+    void setHistory(EfsmHistory* history) { history_ = history; }
+    void resetSession();   // descarta o QJSEngine (recriado no próximo passo)
+
+    // transições disparadas desde o último reset() (restaurável: histórico, checkpoint)
+    qint64 stepCount() const { return steps_; }
+    void setStepCount(qint64 steps) { steps_ = steps; }
+
+    int  currentState() const { return current_; }
+    void setCurrentState(int s) { current_ = s; }
+    bool isFinal() const {
+        return current_ >= 0 && current_ < model_.states.size() && model_.states[current_].final;
+    }
+
+    // Valuations: um vetor de slots tipados X | I | O. O índice k de
+    // model().vars/inputs/outputs vira o slot k, nx+k e nx+ni+k.
+    const QVector<EfsmValue>& values() const { return slots_; }
+    int slotOf(const QString& name) const { return slotOf_.value(name, -1); }   // -1: ausente/ambíguo
+    int inputSlot(int k)  const { return nx_ + k; }
+    int outputSlot(int k) const { return nx_ + ni_ + k; }
+    const EfsmValue& var(int k)    const { return slots_[k]; }
+    const EfsmValue& input(int k)  const { return slots_[nx_ + k]; }
+    const EfsmValue& output(int k) const { return slots_[nx_ + ni_ + k]; }
+    QVector<EfsmValue> vars()    const { return slots_.mid(0, nx_); }
+    QVector<EfsmValue> inputs()  const { return slots_.mid(nx_, ni_); }
+    QVector<EfsmValue> outputs() const { return slots_.mid(nx_ + ni_, no_); }
+    void setVar(int k, const EfsmValue& v)    { if (k >= 0 && k < nx_) assign(k, v); }
+    void setInput(int k, const EfsmValue& v)  { if (k >= 0 && k < ni_) assign(nx_ + k, v); }
+    void setOutput(int k, const EfsmValue& v) { if (k >= 0 && k < no_) assign(nx_ + ni_ + k, v); }
+
+    // edição de scripts sem reconstruir a sessão
+    void setGuard(int transition, const QString& guard);
+    void setAction(int transition, const QString& action);
+
+    // edição estrutural incremental (mesma semântica de EfsmModel):
+    // a ordem (prioridade, id) por estado é mantida sem setModel()
+    int  addTransition(const EfsmTransition& t);
+    void removeTransition(int transition);   // a última passa a ocupar o índice
+    void setPriority(int transition, int priority);
+    // nome/inicial/final de um estado: mantém estado corrente, X|I|O,
+    // contador de passos, histórico e perfil (inicial só vale no próximo reset())
+    void setStateInfo(int state, const QString& name, bool initial, bool final);
+
+    StepResult step();
+
+    void setBreakpoints(const QVector<Breakpoint>& breakpoints);
+    const QVector<Breakpoint>& breakpoints() const { return breakpoints_; }
+    // condições passam a partir do valor atual: uma que já é verdadeira só
+    // para depois de voltar a ser falsa (retomar após parar numa delas)
+    void primeConditions();
+
+    // Watches: expressões avaliadas no mesmo contexto das guardas (VM ou JS),
+    // compiladas uma vez; erro => valor vazio e mensagem em *errors
+    void setWatches(const QStringList& expressions);
+    QVector<EfsmValue> watchValues(QStringList* errors = nullptr);
+
+    // avaliações de guarda feitas de fato x respondidas pelo memo
+    struct GuardStats { qint64 evaluated = 0; qint64 cached = 0; };
+    const GuardStats& guardStats() const { return guardStats_; }
+    void resetGuardStats() { guardStats_ = GuardStats(); }
+
+    // Perfil por transição/estado. Desligado custa um teste por guarda e por
+    // passo; ligado, duas leituras de relógio por guarda e por ação.
+    struct TransitionProfile {
+        qint64 guardEvals = 0;   // inclui as respondidas pelo memo
+        qint64 guardNs = 0;
+        qint64 fires = 0;
+        qint64 actionNs = 0;
+    };
+    void setProfiling(bool on) { profiling_ = on; }
+    bool profiling() const { return profiling_; }
+    void resetProfile();
+    const QVector<TransitionProfile>& transitionProfile() const { return profile_; }   // por transição
+    const QVector<qint64>& stateEntries() const { return stateEntries_; }               // por estado
+    // soma o perfil de outro engine com a mesma estrutura (ex.: o do EfsmWorker)
+    void addProfile(const QVector<TransitionProfile>& transitions, const QVector<qint64>& states);
+
+    // Execução em lote: dispara passos seguidos sem voltar ao chamador.
+    struct RunLimits {
+        qint64 maxSteps  = -1;     // -1 = sem limite de passos
+        qint64 maxMillis = -1;     // -1 = sem limite de tempo
+        bool stopAtFinal = true;   // para ao entrar num estado final
+        const std::atomic<bool>* cancel = nullptr;   // conferido a cada passo (outra thread)
+    };
+    struct RunResult {
+        qint64 steps = 0;                    // transições disparadas
+        StepStatus status = StepStatus::Fired; // do último passo; Fired = parou por limite/final
+        bool reachedFinal = false;
+        int transition = -1;                 // última disparada (ou a que falhou)
+        int breakpoint = -1;                 // atingido no último passo (parou por ele)
+        QString error;                       // ActionError
+        QString guardError;                  // última guarda inválida vista
+        QVector<int> changedVars;            // união dos índices alterados, sem repetição
+        QVector<int> changedOutputs;
+    };
+    RunResult run(const RunLimits& limits);
+
+    // tempo do script JS em curso (0: nenhum) e interrupção dele; seguros
+    // entre threads. Sem efeito antes do Qt 5.14 (sem QJSEngine::setInterrupted).
+    qint64 scriptElapsedNs() const;
+    void interruptScript();
+
+    // conversões JS <-> valor tipado (bool/int/string)
+    static QJSValue  toJsValue(const EfsmValue& v);
+    static EfsmValue fromJsValue(const QJSValue& v);
+    static bool jsToBool(const QJSValue& v, bool& ok);
+
+private:
+    enum class ScriptKind { Guard, Action };
+    struct CompiledScript {
+        EfsmVm::Program vm; // válido se o texto está no subconjunto nativo
+        QString  source;    // texto normalizado (JS)
+        QJSValue fn;        // function(){...} pronta para call()
+        bool jsReady  = false;
+        bool callable = false;   // false: evaluate(source) a cada chamada
+        ScriptKind kind = ScriptKind::Guard;
+        // memo (só guardas): válido enquanto nenhum slot de reads mudar
+        QVector<int> reads;
+        bool memoizable = false;
+        bool memoValid  = false;
+        bool memoValue  = false;
+        quint64 memoEpoch = 0;
+    };
+    int compile(const QString& text, ScriptKind kind);   // índice em scripts_
+    QJSValue runJs(CompiledScript& cs);
+    bool evalGuard(int script, bool& value, QString& error);
+    void stepInto(StepResult& r);   // step() reaproveitando os buffers de r
+    void clearScripts();
+    void indexBreakpoints();
+    int  checkBreakpoints(int transition);   // -1: nenhum atingido
+
+    void assign(int slot, const EfsmValue& v);
+    void touch(int slot) { slotEpoch_[slot] = ++epoch_; }
+    void markChanged(int slot, StepResult& r);   // X/O alterado pela ação
+    void markAllStale();
+    void syncToJs();       // cria a sessão se preciso e envia só os slots "stale"
+
+    EfsmModel model_;
+    int current_ = -1;
+    qint64 steps_ = 0;
+
+    // valuations tipadas, lidas direto pelo VM: slots = X | I | O
+    QVector<EfsmValue> slots_;
+    int nx_ = 0, ni_ = 0, no_ = 0;
+    QVector<QString> slotName_;    // slot -> nome (global JS)
+    QHash<QString, int> slotOf_;   // nome -> slot (-1 se ambíguo entre X/I/O)
+    EfsmHistory* history_ = nullptr;
+    QVector<quint64> slotEpoch_;   // por slot: época da última mudança de valor
+    quint64 epoch_ = 0;
+    GuardStats guardStats_;
+    // breakpoints e watches (scripts compilados sob demanda; -1 = ainda não)
+    QVector<Breakpoint> breakpoints_;
+    QVector<int> bpState_, bpTransition_;   // por estado/transição: breakpoint ou -1
+    struct ConditionBp { int breakpoint; int script = -1; bool last = false; };
+    QVector<ConditionBp> bpConditions_;
+    bool evalCondition(ConditionBp& c);   // erro conta como falsa
+    QStringList watches_;
+    QVector<int> watchFn_;
+
+    bool profiling_ = false;
+    QVector<TransitionProfile> profile_;
+    QVector<qint64> stateEntries_;
+
+    // sessão JS persistente
+    std::unique_ptr<QJSEngine> js_;
+    // watchdog: início do script em curso (ns, 0 = nenhum); jsMutex_ protege
+    // a troca de js_ e o par jsSince_/interrupted_ em volta de cada chamada
+    // contra uma interrupção vinda de outra thread
+    std::atomic<qint64> jsSince_{0};
+    std::atomic<bool> interrupted_{false};
+    mutable std::mutex jsMutex_;
+    QJSValue global_;
+    QVector<bool> stale_;                      // por slot: global JS desatualizado
+    bool anyStale_ = true;
+
+    // cache de scripts compilados (vale para a sessão JS corrente)
+    QVector<CompiledScript> scripts_;
+    QHash<QString, int> scriptIndex_;          // texto normalizado -> scripts_
+    QVector<int> guardFn_, actionFn_;          // por transição; -1 = não compilado
+};
@@ -0,0 +1,357 @@
+#include "EfsmExplorer.h"
+#include "EfsmConfig.h"
+#include <QJsonArray>
+#include <QElapsedTimer>
+#include <QThread>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// ===== conjunto concorrente de impressões digitais =====
+// Fragmentado por hash; cada fragmento é uma tabela de endereçamento
+// aberto (8 bytes por entrada, carga <= 1/2) protegida pelo próprio mutex.
+class FingerprintSet {
+public:
+    bool insert(quint64 fp){
+        if (fp == 0) fp = 1;   // 0 marca posição vazia
+        Shard& s = shards_[fp & (kShards - 1)];
+        std::lock_guard<std::mutex> lock(s.m);
+        if ((s.count + 1) * 2 > s.table.size()) grow(s);
+        const int mask = s.table.size() - 1;
+        for (int i = int(fp >> 8) & mask; ; i = (i + 1) & mask){
+            if (s.table[i] == fp) return false;
+            if (s.table[i] == 0) { s.table[i] = fp; ++s.count; return true; }
+        }
+    }
+
+private:
+    static constexpr int kShards = 256;
+    struct Shard {
+        std::mutex m;
+        QVector<quint64> table;
+        int count = 0;
+    };
+
+    static void grow(Shard& s){
+        QVector<quint64> old;
+        old.swap(s.table);
+        s.table.fill(0, qMax(64, old.size() * 2));
+        const int mask = s.table.size() - 1;
+        for (quint64 fp : old){
+            if (!fp) continue;
+            int i = int(fp >> 8) & mask;
+            while (s.table[i]) i = (i + 1) & mask;
+            s.table[i] = fp;
+        }
+    }
+
+    std::unique_ptr<Shard[]> shards_{ new Shard[kShards] };
+};
+
+// ===== filas com roubo =====
+struct WorkQueue {
+    std::mutex m;
+    std::deque<QByteArray> q;
+
+    void push(QByteArray&& c){ std::lock_guard<std::mutex> l(m); q.push_back(std::move(c)); }
+    bool popFront(QByteArray& c){   // dono: ordem de chegada (largura)
+        std::lock_guard<std::mutex> l(m);
+        if (q.empty()) return false;
+        c = std::move(q.front()); q.pop_front();
+        return true;
+    }
+    bool stealBack(QByteArray& c){  // ladrão: o mais recente, longe do dono
+        std::lock_guard<std::mutex> l(m);
+        if (q.empty()) return false;
+        c = std::move(q.back()); q.pop_back();
+        return true;
+    }
+};
+
+struct WorkerResult {
+    qint64 edges = 0, deadlocks = 0, actionErrors = 0, errorStuck = 0;
+    QVector<bool> stateReached, transitionFired;
+    QVector<EfsmExplorer::Deadlock> deadlockSamples;
+};
+
+// inteiro exato de um número JSON (|n| <= 2^53); false se não for
+bool jsonInteger(const QJsonValue& v, qint64& n){
+    if (!v.isDouble()) return false;
+    const double d = v.toDouble();
+    if (!(std::fabs(d) <= 9007199254740992.0) || std::floor(d) != d) return false;
+    n = qint64(d);
+    return true;
+}
+
+} // namespace
+
+bool EfsmExplorer::Options::fromJson(const QJsonObject& o, const EfsmModel& model,
+                                     Options& out, QString* error){
+    out = Options();
+    const QJsonObject ins = o.value("inputs").toObject();
+    for (auto it = ins.begin(); it != ins.end(); ++it){
+        bool known = false;
+        for (const auto& in : model.inputs) if (in.name == it.key()) { known = true; break; }
+        if (!known){
+            if (error) *error = QString("Input desconhecido no domínio: %1").arg(it.key());
+            return false;
+        }
+        InputDomain d;
+        d.name = it.key();
+        const QJsonValue v = it.value();
+        if (v.isString() && v.toString() == "bool"){
+            d.values = { EfsmValue::fromBool(false), EfsmValue::fromBool(true) };
+        } else if (v.isArray() || v.isObject()){
+            // [lo,hi] inteiros ou {"range":[lo,hi]}: intervalo; {"values":[…]} ou
+            // qualquer outro array: lista
+            const QJsonObject form = v.toObject();
+            const bool explicitRange = form.contains("range");
+            const QJsonArray a = v.isArray() ? v.toArray()
+                               : form.value(explicitRange ? "range" : "values").toArray();
+            qint64 lo = 0, hi = 0;
+            const bool range = a.size() == 2 && jsonInteger(a[0], lo) && jsonInteger(a[1], hi)
+                               && (explicitRange || !v.isObject());
+            if (explicitRange && !range){
+                if (error) *error = QString("\"range\" do input %1 deve ser [lo, hi] inteiros").arg(d.name);
+                return false;
+            }
+            if (range){
+                if (hi < lo){
+                    if (error) *error = QString("Intervalo invertido para o input %1: [%2, %3]")
+                                            .arg(d.name).arg(lo).arg(hi);
+                    return false;
+                }
+                if (hi - lo >= kMaxRangeValues){
+                    if (error) *error = QString("Intervalo grande demais para o input %1: [%2, %3] "
+                                                "(máximo de %4 valores)")
+                                            .arg(d.name).arg(lo).arg(hi).arg(kMaxRangeValues);
+                    return false;
+                }
+                for (qint64 n = lo; n <= hi; ++n) d.values.push_back(EfsmValue::fromInt(n));
+            } else {
+                for (const auto& e : a) d.values.push_back(EfsmModel::decodeJsonValue(e));
+            }
+        } else {
+            d.values.push_back(EfsmModel::decodeJsonValue(v));   // valor fixo
+        }
+        if (d.values.isEmpty()){
+            if (error) *error = QString("Domínio vazio para o input %1").arg(d.name);
+            return false;
+        }
+        out.inputs.push_back(d);
+    }
+    out.maxConfigurations = (qint64)o.value("maxConfigurations").toDouble(out.maxConfigurations);
+    out.threads = o.value("threads").toInt(0);
+    out.includeOutputs = o.value("includeOutputs").toBool(true);
+    return true;
+}
+
+EfsmExplorer::Result EfsmExplorer::explore(const EfsmModel& model, const Options& options,
+                                           const ProgressFn& progress,
+                                           const std::atomic<bool>* cancel){
+    Result res;
+    QElapsedTimer clock;
+    clock.start();
+    res.stateReached.fill(false, model.states.size());
+    res.transitionFired.fill(false, model.transitions.size());
+
+    const int init = model.initialState();
+    if (init < 0) { res.elapsedMs = clock.elapsed(); return res; }
+    res.stateReached[init] = true;
+
+    // inputs do domínio -> índices em I
+    QVector<int> domIdx;
+    QVector<QVector<EfsmValue>> domVals;
+    for (const auto& d : options.inputs){
+        for (int k=0; k<model.inputs.size(); ++k)
+            if (model.inputs[k].name == d.name) { domIdx.push_back(k); domVals.push_back(d.values); break; }
+    }
+
+    const int nx = model.vars.size();
+    const int no = options.includeOutputs ? model.outputs.size() : 0;
+    int threads = options.threads > 0 ? options.threads : QThread::idealThreadCount();
+    threads = qMax(1, threads);
+
+    FingerprintSet seen;
+    std::vector<WorkQueue> queues(threads);
+    std::atomic<qint64> pending{0};        // na fila ou em expansão
+    std::atomic<qint64> configs{0};
+    std::atomic<bool> stop{false};
+    std::vector<WorkerResult> partial(threads);
+
+    // configuração inicial
+    {
+        EfsmEngine e(model);
+        QByteArray c = EfsmConfig::encode(e, options.includeOutputs);
+        seen.insert(EfsmConfig::fingerprint(c));
+        configs = 1;
+        pending = 1;
+        queues[0].push(std::move(c));
+    }
+
+    auto worker = [&](int id){
+        WorkerResult& wr = partial[id];
+        wr.stateReached.fill(false, model.states.size());
+        wr.transitionFired.fill(false, model.transitions.size());
+        EfsmEngine e(model);   // engine e sessão JS próprios
+        QVector<int> odo(domIdx.size());
+        QByteArray c;
+        qint64 expanded = 0;
+        int idle = 0;
+
+        while (!stop.load(std::memory_order_relaxed)){
+            bool got = queues[id].popFront(c);
+            for (int k=1; !got && k<threads; ++k)
+                got = queues[(id + k) % threads].stealBack(c);
+            if (!got){
+                if (pending.load() == 0) break;   // ninguém mais vai produzir
+                // ocioso: cede a vez algumas vezes, depois dorme um pouco em
+                // vez de girar num núcleo enquanto os outros expandem
+                if (++idle < 16) std::this_thread::yield();
+                else             std::this_thread::sleep_for(std::chrono::microseconds(200));
+                continue;
+            }
+            idle = 0;
+
+            // decodifica a configuração
+            const int state = EfsmConfig::state(c);
+            const QVector<EfsmValue> vals = EfsmConfig::values(c, nx + no);
+
+            // todas as combinações de inputs do domínio (odômetro)
+            bool anyFired = false, anyError = false;
+            odo.fill(0);
+            for (;;){
+                e.setCurrentState(state);
+                for (int k=0; k<nx; ++k) e.setVar(k, vals[k]);
+                for (int k=0; k<model.outputs.size(); ++k)
+                    e.setOutput(k, k < no ? vals[nx + k] : model.outputs[k].value);
+                for (int d=0; d<domIdx.size(); ++d) e.setInput(domIdx[d], domVals[d][odo[d]]);
+
+                const EfsmEngine::StepResult r = e.step();
+                if (r.status == EfsmEngine::StepStatus::Fired){
+                    anyFired = true;
+                    ++wr.edges;
+                    wr.transitionFired[r.transition] = true;
+                    wr.stateReached[e.currentState()] = true;
+                    QByteArray next = EfsmConfig::encode(e, options.includeOutputs);
+                    if (seen.insert(EfsmConfig::fingerprint(next))){
+                        if (configs.fetch_add(1) + 1 >= options.maxConfigurations) stop = true;
+                        pending.fetch_add(1);
+                        queues[id].push(std::move(next));
+                    }
+                } else if (r.status == EfsmEngine::StepStatus::ActionError){
+                    anyError = true;
+                    ++wr.actionErrors;
+                }
+
+                int d = 0;
+                for (; d<odo.size(); ++d){
+                    if (++odo[d] < domVals[d].size()) break;
+                    odo[d] = 0;
+                }
+                if (d == odo.size()) break;   // deu a volta
+            }
+
+            // deadlock só se nenhuma combinação tinha transição habilitada;
+            // sem sucessora por erro de ação é contado à parte
+            if (!anyFired && anyError){
+                ++wr.errorStuck;
+            } else if (!anyFired && !model.states[state].final){
+                ++wr.deadlocks;
+                if (wr.deadlockSamples.size() < options.deadlockSamples)
+                    wr.deadlockSamples.push_back({ state, vals.mid(0, nx) });
+            }
+            pending.fetch_sub(1);
+
+            if ((++expanded & 63) == 0){
+                if (cancel && cancel->load()) stop = true;
+                if (id == 0 && progress){
+                    Progress pr;
+                    pr.configurations = configs.load();
+                    pr.frontier = pending.load();
+                    pr.elapsedMs = clock.elapsed();
+                    pr.perSecond = pr.elapsedMs > 0 ? pr.configurations * 1000 / pr.elapsedMs : 0;
+                    progress(pr);
+                }
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (int t=1; t<threads; ++t) pool.emplace_back(worker, t);
+    worker(0);
+    for (auto& th : pool) th.join();
+
+    // junta os resultados parciais
+    for (const WorkerResult& wr : partial){
+        res.edges += wr.edges;
+        res.deadlocks += wr.deadlocks;
+        res.actionErrors += wr.actionErrors;
+        res.errorStuck += wr.errorStuck;
+        for (int i=0; i<res.stateReached.size(); ++i)    res.stateReached[i] = res.stateReached[i] || wr.stateReached.value(i);
+        for (int i=0; i<res.transitionFired.size(); ++i) res.transitionFired[i] = res.transitionFired[i] || wr.transitionFired.value(i);
+        for (const auto& d : wr.deadlockSamples)
+            if (res.deadlockSamples.size() < options.deadlockSamples) res.deadlockSamples.push_back(d);
+    }
+    res.configurations = configs.load();
+    res.complete = !stop.load();
+    res.elapsedMs = clock.elapsed();
+    if (progress){
+        Progress pr;
+        pr.configurations = res.configurations;
+        pr.elapsedMs = res.elapsedMs;
+        pr.perSecond = res.elapsedMs > 0 ? res.configurations * 1000 / res.elapsedMs : 0;
+        progress(pr);
+    }
+    return res;
+}
+
+double EfsmExplorer::Result::collisionProbability() const {
+    // aniversário: 1 - exp(-n(n-1)/2 / 2^64)
+    const double n = double(configurations);
+    return -std::expm1(-n * (n - 1.0) / 36893488147419103232.0);
+}
+
+QString EfsmExplorer::Result::summary(const EfsmModel& model) const {
+    QStringList lines;
+    const qint64 ms = qMax<qint64>(1, elapsedMs);
+    lines << QString("%1 configurações, %2 passos em %3 ms (%4 configurações/s)%5")
+                 .arg(configurations).arg(edges).arg(elapsedMs)
+                 .arg(configurations * 1000 / ms)
+                 .arg(complete ? QString() : QString(" — INCOMPLETA (limite/cancelada)"));
+    lines << QString("Exploração probabilística (impressões digitais de 64 bits): "
+                     "chance estimada de colisão %1").arg(collisionProbability(), 0, 'g', 2);
+
+    QStringList unreached;
+    for (int i=0; i<stateReached.size(); ++i)
+        if (!stateReached[i]) unreached << model.states[i].name;
+    lines << QString("Estados alcançados: %1 de %2").arg(stateReached.count(true)).arg(stateReached.size());
+    if (!unreached.isEmpty()) lines << "  inalcançáveis: " + unreached.join(", ");
+
+    QStringList dead;
+    for (int i=0; i<transitionFired.size(); ++i){
+        if (transitionFired[i]) continue;
+        const auto& t = model.transitions[i];
+        dead << QString("%1 → %2 [%3]").arg(model.states[t.from].name, model.states[t.to].name, t.guard);
+    }
+    lines << QString("Transições mortas: %1").arg(dead.size());
+    for (const auto& d : dead) lines << "  " + d;
+
+    lines << QString("Deadlocks (estado não final sem transição habilitada): %1").arg(deadlocks);
+    for (const auto& d : deadlockSamples){
+        QStringList xs;
+        for (int k=0; k<d.vars.size() && k<model.vars.size(); ++k)
+            xs << model.vars[k].name + "=" + d.vars[k].toString();
+        lines << QString("  %1 {%2}").arg(model.states[d.state].name, xs.join(", "));
+    }
+    if (actionErrors) lines << QString("Erros de ação: %1 (configurações sem sucessora só por erro: %2)")
+                                   .arg(actionErrors).arg(errorStuck);
+    return lines.join('\n');
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include "EfsmEngine.h"
+#include <QJsonObject>
+#include <atomic>
+#include <functional>
+
+// Exploração explícita do espaço de configurações (estado, X, O) alcançáveis
+// a partir do inicial, para um domínio finito de inputs: a cada
+// configuração, todas as combinações de valores de I são aplicadas e cada
+// passo do engine gera uma sucessora.
+//
+// Paralelismo: cada worker tem a própria fila (e o próprio EfsmEngine);
+// processa a sua em ordem FIFO (largura) e, ociosa, rouba do fim da fila
+// de outra. Configurações vistas ficam num conjunto fragmentado por hash
+// (um mutex por fragmento) guardando só uma impressão digital de 64 bits —
+// a configuração completa só existe enquanto está na fronteira.
+//
+// Por isso a exploração é probabilística: duas configurações distintas com a
+// mesma impressão digital contam como uma só, e a segunda (com o que só ela
+// alcançaria) é podada sem aviso. Com n configurações a chance de alguma
+// colisão é ~ n²/2^65 (≈ 3·10^-6 para 10^7); summary() informa a estimativa.
+class EfsmExplorer {
+public:
+    struct InputDomain {
+        QString name;
+        QVector<EfsmValue> values;   // valores possíveis (não vazio)
+    };
+
+    struct Options {
+        QVector<InputDomain> inputs;        // inputs ausentes ficam no valor do modelo
+        qint64 maxConfigurations = 50000000;
+        int threads = 0;                    // <= 0: QThread::idealThreadCount()
+        bool includeOutputs = true;         // O faz parte da configuração (ações leem O)
+        int deadlockSamples = 16;
+
+        // {"inputs":{"go":"bool","n":[0,3],"mode":["a","b"]},"maxConfigurations":N}
+        // "bool" = {false,true}; [lo,hi] inteiros = intervalo; demais arrays = lista.
+        // Um array de exatamente dois inteiros é sempre intervalo: para a lista
+        // só com lo e hi use {"values":[lo,hi]} ({"range":[lo,hi]} também vale).
+        // Intervalos com hi < lo ou mais de kMaxRangeValues valores são erro
+        // (cada valor multiplica as combinações de inputs por configuração).
+        static constexpr qint64 kMaxRangeValues = 4096;
+        static bool fromJson(const QJsonObject& o, const EfsmModel& model,
+                             Options& out, QString* error = nullptr);
+    };
+
+    struct Progress {
+        qint64 configurations = 0;   // distintas já vistas
+        qint64 frontier = 0;         // aguardando expansão
+        qint64 elapsedMs = 0;
+        qint64 perSecond = 0;
+    };
+    using ProgressFn = std::function<void(const Progress&)>;   // chamada de um worker
+
+    struct Deadlock {
+        int state = -1;
+        QVector<EfsmValue> vars;     // X da configuração sem nenhuma transição habilitada
+    };
+
+    struct Result {
+        qint64 configurations = 0;
+        qint64 edges = 0;            // passos disparados durante a exploração
+        qint64 deadlocks = 0;        // não finais: nenhuma combinação de inputs habilitou transição
+        qint64 actionErrors = 0;     // passos com erro na ação (combinações)
+        qint64 errorStuck = 0;       // sem sucessora, mas por erro de ação (não é deadlock)
+        QVector<bool> stateReached;        // por índice de model.states
+        QVector<bool> transitionFired;     // por índice de model.transitions; false = morta
+        QVector<Deadlock> deadlockSamples;
+        bool complete = true;        // false: limite atingido ou cancelado
+        qint64 elapsedMs = 0;
+        double collisionProbability() const;   // estimativa de colisão de impressões digitais
+        QString summary(const EfsmModel& model) const;
+    };
+
+    static Result explore(const EfsmModel& model, const Options& options,
+                          const ProgressFn& progress = ProgressFn(),
+                          const std::atomic<bool>* cancel = nullptr);
+};
@@ -0,0 +1,141 @@
+#include "EfsmHistory.h"
+#include "EfsmEngine.h"
+
+namespace {
+
+const EfsmValue& valueOf(const EfsmEngine& e, int nx, int index){
+    return index < nx ? e.var(index) : e.output(index - nx);
+}
+
+} // namespace
+
+void EfsmHistory::setCapacity(int capacity){
+    capacity_ = qMax(2, capacity);
+    while (int(frames_.size()) > capacity_) evictFront();
+}
+
+void EfsmHistory::clear(){
+    frames_.clear();
+    arena_.clear();
+    arenaBase_ = 0;
+    keys_.clear();
+    base_.clear();
+    live_.clear();
+    edits_.clear();
+    cursor_ = 0;
+}
+
+int EfsmHistory::transitionAt(qint64 step) const {
+    if (frames_.empty() || step < firstStep() || step > lastStep()) return -1;
+    return frames_[std::size_t(step - firstStep())].transition;
+}
+
+void EfsmHistory::start(const EfsmEngine& e){
+    clear();
+    nx_ = e.model().vars.size();
+    size_ = nx_ + e.model().outputs.size();
+    live_.fill(QVector<EfsmValue>(kChunk), (size_ + kChunk - 1) / kChunk);
+    for (int k=0; k<size_; ++k) put(live_, k, valueOf(e, nx_, k));
+
+    Frame f;
+    f.step = e.stepCount();
+    f.state = e.currentState();
+    base_ = live_;
+    frames_.push_back(f);
+    cursor_ = f.step;
+}
+
+void EfsmHistory::noteEdit(int index){
+    if (!frames_.empty() && !edits_.contains(index)) edits_.push_back(index);
+}
+
+void EfsmHistory::record(const EfsmEngine& e, int transition,
+                         const QVector<int>& changedVars, const QVector<int>& changedOutputs){
+    if (frames_.empty()) { start(e); return; }
+    // depois de um restore(): o passo novo abre outro ramo
+    truncateAfter(cursor_);
+
+    Frame f;
+    f.step = frames_.back().step + 1;
+    f.state = e.currentState();
+    f.transition = transition;
+    f.deltaBegin = arenaBase_ + qint64(arena_.size());
+    auto take = [&](int index){
+        const EfsmValue& v = valueOf(e, nx_, index);
+        if (v == get(live_, index)) return;   // repetido ou voltou ao mesmo valor
+        put(live_, index, v);                 // copia só o bloco, se compartilhado
+        arena_.push_back({ index, v });
+        ++f.deltaCount;
+    };
+    for (int k : edits_)         take(k);
+    for (int k : changedVars)    take(k);
+    for (int k : changedOutputs) take(nx_ + k);
+    edits_.clear();
+    if (f.step % kKeyEvery == 0) keys_.push_back({ f.step, live_ });
+
+    frames_.push_back(f);
+    cursor_ = frames_.back().step;
+    if (int(frames_.size()) > capacity_) evictFront();
+}
+
+void EfsmHistory::applyDeltas(Chunks& c, const Frame& f) const {
+    const std::size_t at = std::size_t(f.deltaBegin - arenaBase_);
+    for (int k=0; k<f.deltaCount; ++k){
+        const Delta& d = arena_[at + std::size_t(k)];
+        put(c, d.index, d.value);
+    }
+}
+
+EfsmHistory::Chunks EfsmHistory::valuesAt(std::size_t frame) const {
+    // quadro-chave mais recente até o passo; senão, a base (primeiro quadro)
+    const qint64 step = frames_[frame].step;
+    std::size_t j = 0;
+    Chunks c = base_;
+    if (!keys_.empty() && keys_.front().step <= step){
+        const Key& k = keys_[std::size_t((step - keys_.front().step) / kKeyEvery)];
+        j = std::size_t(k.step - firstStep());
+        c = k.values;
+    }
+    for (++j; j <= frame; ++j) applyDeltas(c, frames_[j]);
+    return c;
+}
+
+void EfsmHistory::evictFront(){
+    if (frames_.size() < 2) return;
+    const Frame old = frames_.front();
+    frames_.pop_front();
+    const Frame& next = frames_.front();
+    if (!keys_.empty() && keys_.front().step == next.step){
+        base_ = keys_.front().values;   // já é X|O completo desse passo
+        keys_.pop_front();
+    } else {
+        applyDeltas(base_, next);
+    }
+    // os deltas do quadro despejado já estão na base
+    for (int k=0; k<old.deltaCount; ++k) arena_.pop_front();
+    arenaBase_ += old.deltaCount;
+}
+
+void EfsmHistory::truncateAfter(qint64 step){
+    if (frames_.back().step <= step) return;
+    while (frames_.back().step > step) frames_.pop_back();
+    const Frame& last = frames_.back();
+    arena_.resize(std::size_t(last.deltaBegin + last.deltaCount - arenaBase_));
+    while (!keys_.empty() && keys_.back().step > step) keys_.pop_back();
+}
+
+bool EfsmHistory::restore(qint64 step, EfsmEngine& e){
+    if (frames_.empty() || step < firstStep() || step > lastStep()) return false;
+    if (e.model().vars.size() != nx_ || nx_ + e.model().outputs.size() != size_) return false;
+
+    const std::size_t i = std::size_t(step - firstStep());
+    const Chunks c = valuesAt(i);
+    e.setCurrentState(frames_[i].state);
+    e.setStepCount(step);
+    for (int k=0; k<nx_; ++k)    e.setVar(k, get(c, k));
+    for (int k=nx_; k<size_; ++k) e.setOutput(k - nx_, get(c, k));
+    edits_.clear();   // os setters acima não são edições do usuário
+    live_ = c;
+    cursor_ = step;
+    return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include "EfsmValue.h"
+#include <QVector>
+#include <deque>
+
+class EfsmEngine;
+
+// Histórico limitado de passos de um EfsmEngine (estado, X, O, transição
+// disparada), para voltar no tempo sem reexecutar.
+//
+// Cada quadro guarda só o que mudou (delta). Os deltas de todos os quadros
+// ficam numa arena única (fila em blocos, sem alocação por quadro); o quadro
+// só guarda o deslocamento e a quantidade. Há quadros-chave com X|O completo
+// em blocos QVector nos passos múltiplos de kKeyEvery (passo fixo, não
+// depende do despejo), e base_ guarda X|O do quadro mais antigo: ao despejar,
+// o delta do novo primeiro quadro é aplicado nela (O(delta), sem promover
+// quadro-chave). Blocos que não mudaram são compartilhados (cópia na escrita
+// do Qt), então um histórico longo custa ~ o tamanho dos deltas.
+//
+// O engine alimenta o histórico (setHistory): start() antes do primeiro
+// passo, record() a cada transição disparada e noteEdit() quando X/O é
+// alterado por fora (tabelas). restore() volta o engine a um passo; o
+// próximo record() descarta os quadros posteriores (ramo novo).
+class EfsmHistory {
+public:
+    explicit EfsmHistory(int capacity = 1 << 20) : capacity_(qMax(2, capacity)) {}
+
+    void setCapacity(int capacity);
+    int capacity() const { return capacity_; }
+    void clear();
+    bool isEmpty() const { return frames_.empty(); }
+
+    // passos disponíveis: [firstStep, lastStep]; cursor = o que o engine mostra
+    qint64 firstStep() const { return frames_.empty() ? 0 : frames_.front().step; }
+    qint64 lastStep()  const { return frames_.empty() ? 0 : frames_.back().step; }
+    qint64 cursor() const { return cursor_; }
+    int transitionAt(qint64 step) const;   // disparada para chegar ao passo (-1: nenhuma)
+
+    void start(const EfsmEngine& e);
+    void record(const EfsmEngine& e, int transition,
+                const QVector<int>& changedVars, const QVector<int>& changedOutputs);
+    void noteEdit(int index);    // índice em X|O
+
+    bool restore(qint64 step, EfsmEngine& e);
+
+private:
+    static constexpr int kChunk = 8;
+    static constexpr int kKeyEvery = 64;
+    using Chunks = QVector<QVector<EfsmValue>>;   // X|O em blocos de kChunk
+
+    struct Delta {
+        int index = 0;          // em X|O
+        EfsmValue value;        // valor novo
+    };
+    struct Frame {
+        qint64 step = 0;
+        int state = -1;
+        int transition = -1;
+        qint64 deltaBegin = 0;  // posição absoluta na arena
+        int deltaCount = 0;
+    };
+    struct Key {
+        qint64 step = 0;        // múltiplo de kKeyEvery
+        Chunks values;
+    };
+
+    static void put(Chunks& c, int index, const EfsmValue& v) { c[index / kChunk][index % kChunk] = v; }
+    static const EfsmValue& get(const Chunks& c, int index) { return c[index / kChunk][index % kChunk]; }
+    Chunks valuesAt(std::size_t frame) const;   // X|O completo do quadro
+    void applyDeltas(Chunks& c, const Frame& f) const;
+    void evictFront();                          // base_ avança um quadro
+    void truncateAfter(qint64 step);            // descarta o ramo após step
+
+    int capacity_;
+    std::deque<Frame> frames_;
+    std::deque<Delta> arena_;    // deltas de todos os quadros, em ordem
+    qint64 arenaBase_ = 0;       // posição absoluta de arena_.front()
+    std::deque<Key> keys_;       // passos em (firstStep, lastStep]
+    Chunks base_;                // X|O do primeiro quadro
+    qint64 cursor_ = 0;
+    int nx_ = 0, size_ = 0;      // |X| e |X|+|O|
+    Chunks live_;                // X|O do último quadro (compartilha com os quadros-chave)
+    QVector<int> edits_;         // alterados por fora desde o último quadro
+};
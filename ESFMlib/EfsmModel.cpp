@@ -0,0 +1,227 @@
+#include "EfsmModel.h"
+#include <QJsonArray>
+#include <QHash>
+#include <algorithm>    // std::sort, std::lower_bound
+#include <cmath>        // std::llround
+
+namespace {
+
+QJsonArray varsToArray(const QVector<EfsmVar>& vs){
+    QJsonArray arr;
+    for (const auto& v : vs){
+        QJsonObject o;
+        o["name"]  = v.name;
+        o["value"] = EfsmModel::encodeJsonValue(v.value);
+        arr.push_back(o);
+    }
+    return arr;
+}
+
+QVector<EfsmVar> arrayToVars(const QJsonArray& arr){
+    QVector<EfsmVar> out;
+    out.reserve(arr.size());
+    for (const auto& v : arr){
+        const auto o = v.toObject();
+        const QString name = o.value("name").toString().trimmed();
+        if (name.isEmpty()) continue;
+        bool dup = false;
+        for (const auto& e : out) if (e.name == name) { dup = true; break; }
+        if (dup) continue;
+        out.push_back({ name, EfsmModel::decodeJsonValue(o.value("value")) });
+    }
+    return out;
+}
+
+} // namespace
+
+void EfsmModel::clear(){
+    states.clear();
+    transitions.clear();
+    vars.clear();
+    inputs.clear();
+    outputs.clear();
+    outgoing_.clear();
+}
+
+void EfsmModel::rebuildIndex(){
+    outgoing_.clear();
+    outgoing_.resize(states.size());
+    for (int i=0; i<transitions.size(); ++i){
+        const int from = transitions[i].from;
+        if (from >= 0 && from < outgoing_.size())
+            outgoing_[from].push_back(i);
+    }
+    for (auto& out : outgoing_)
+        std::sort(out.begin(), out.end(), [this](int a, int b){ return firesBefore(a, b); });
+}
+
+bool EfsmModel::firesBefore(int a, int b) const {
+    const auto& ta = transitions[a];
+    const auto& tb = transitions[b];
+    if (ta.priority != tb.priority) return ta.priority < tb.priority;
+    return ta.id < tb.id;   // empate: a mais antiga
+}
+
+void EfsmModel::indexInsert(int t){
+    const int from = transitions[t].from;
+    if (from < 0 || from >= outgoing_.size()) return;
+    auto& out = outgoing_[from];
+    const auto pos = std::lower_bound(out.begin(), out.end(), t,
+                                      [this](int a, int b){ return firesBefore(a, b); });
+    out.insert(pos, t);
+}
+
+void EfsmModel::indexErase(int t){
+    const int from = transitions[t].from;
+    if (from < 0 || from >= outgoing_.size()) return;
+    outgoing_[from].removeOne(t);
+}
+
+int EfsmModel::addTransition(const EfsmTransition& t){
+    transitions.push_back(t);
+    const int idx = transitions.size()-1;
+    indexInsert(idx);
+    return idx;
+}
+
+void EfsmModel::removeTransition(int t){
+    if (t < 0 || t >= transitions.size()) return;
+    indexErase(t);
+    const int last = transitions.size()-1;
+    if (t != last){
+        // a última ocupa o lugar: só a lista do estado de origem dela muda
+        transitions[t] = transitions[last];
+        const int from = transitions[t].from;
+        if (from >= 0 && from < outgoing_.size()){
+            auto& out = outgoing_[from];
+            const int k = out.indexOf(last);
+            if (k >= 0) out[k] = t;
+        }
+    }
+    transitions.pop_back();
+}
+
+void EfsmModel::setTransitionPriority(int t, int priority){
+    if (t < 0 || t >= transitions.size() || transitions[t].priority == priority) return;
+    indexErase(t);
+    transitions[t].priority = priority;
+    indexInsert(t);
+}
+
+const QVector<int>& EfsmModel::outgoing(int state) const {
+    static const QVector<int> empty;
+    if (state < 0 || state >= outgoing_.size()) return empty;
+    return outgoing_[state];
+}
+
+int EfsmModel::initialState() const {
+    for (int i=0; i<states.size(); ++i)
+        if (states[i].initial) return i;
+    return -1;
+}
+
+int EfsmModel::stateIndex(const QString& name) const {
+    for (int i=0; i<states.size(); ++i)
+        if (states[i].name == name) return i;
+    return -1;
+}
+
+QJsonValue EfsmModel::encodeJsonValue(const EfsmValue& v){
+    switch (v.type){
+    case EfsmValue::Bool: return QJsonValue(v.i != 0);
+    case EfsmValue::Int:  return QJsonValue((double)v.i);
+    default:              return QJsonValue(v.s);
+    }
+}
+
+EfsmValue EfsmModel::decodeJsonValue(const QJsonValue& v){
+    if (v.isBool())   return EfsmValue::fromBool(v.toBool());
+    if (v.isDouble()) return EfsmValue::fromInt(std::llround(v.toDouble()));
+    return EfsmValue::parse(v.toString());
+}
+
+QJsonObject EfsmModel::toJson() const {
+    QJsonObject root;
+    root["vars"]    = varsToArray(vars);
+    root["inputs"]  = varsToArray(inputs);
+    root["outputs"] = varsToArray(outputs);
+
+    QJsonArray jstates;
+    for (const auto& s : states){
+        QJsonObject o;
+        o["name"]    = s.name;
+        o["x"]       = s.x;
+        o["y"]       = s.y;
+        o["initial"] = s.initial;
+        o["final"]   = s.final;
+        jstates.push_back(o);
+    }
+    root["states"] = jstates;
+
+    // salvar na ordem de criação/ID para manter aparência (paralelas/self-loops)
+    QVector<int> order(transitions.size());
+    for (int i=0; i<order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [this](int a, int b){
+        return transitions[a].id < transitions[b].id;
+    });
+
+    QJsonArray jtrans;
+    for (int i : order){
+        const auto& t = transitions[i];
+        QJsonObject o;
+        o["from"]     = states[t.from].name;
+        o["to"]       = states[t.to].name;
+        o["guard"]    = t.guard;
+        o["action"]   = t.action;
+        o["priority"] = t.priority;
+        o["label"]    = t.label;
+        jtrans.push_back(o);
+    }
+    root["transitions"] = jtrans;
+    return root;
+}
+
+bool EfsmModel::fromJson(const QJsonObject& root, QString* error){
+    clear();
+    if (!root.value("states").isArray()){
+        if (error) *error = "Chave \"states\" ausente ou inválida.";
+        return false;
+    }
+
+    QHash<QString, int> name2state;
+    for (const auto& v : root.value("states").toArray()){
+        const auto o = v.toObject();
+        EfsmState s;
+        s.name    = o.value("name").toString();
+        s.x       = o.value("x").toDouble();
+        s.y       = o.value("y").toDouble();
+        s.initial = o.value("initial").toBool();
+        s.final   = o.value("final").toBool();
+        name2state.insert(s.name, states.size());
+        states.push_back(s);
+    }
+
+    // transições na ordem salva: o id reproduz a ordem de criação
+    for (const auto& v : root.value("transitions").toArray()){
+        const auto o = v.toObject();
+        const int from = name2state.value(o.value("from").toString(), -1);
+        const int to   = name2state.value(o.value("to").toString(),   -1);
+        if (from < 0 || to < 0) continue;
+        EfsmTransition t;
+        t.id       = transitions.size() + 1;
+        t.from     = from;
+        t.to       = to;
+        t.priority = o.value("priority").toInt(1);
+        t.guard    = o.value("guard").toString("true");
+        t.action   = o.value("action").toString();
+        t.label    = o.value("label").toString();
+        transitions.push_back(t);
+    }
+
+    vars    = arrayToVars(root.value("vars").toArray());
+    inputs  = arrayToVars(root.value("inputs").toArray());
+    outputs = arrayToVars(root.value("outputs").toArray());
+
+    rebuildIndex();
+    return true;
+}
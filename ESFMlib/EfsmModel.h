@@ -0,0 +1,72 @@
+#pragma once
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <QJsonValue>
+#include "EfsmValue.h"
+
+// Modelo EFSM "puro": nada de QGraphicsItem nem QApplication.
+// Estados e transições são referenciados pelo índice no respectivo vetor;
+// a GUI (StateItem/TransitionItem) é apenas uma visão sobre estes dados.
+
+struct EfsmVar {
+    QString   name;
+    EfsmValue value;
+};
+
+struct EfsmState {
+    QString name;
+    qreal x = 0.0;           // posição: só interessa à GUI/persistência
+    qreal y = 0.0;
+    bool initial = false;
+    bool final   = false;
+};
+
+struct EfsmTransition {
+    int id = 0;              // ordem de criação (desempate + persistência)
+    int from = -1;           // índice em EfsmModel::states
+    int to   = -1;
+    int priority = 1;
+    QString guard{"true"};
+    QString action;
+    QString label;
+};
+
+struct EfsmModel {
+    QVector<EfsmState>      states;
+    QVector<EfsmTransition> transitions;
+    QVector<EfsmVar> vars;     // X
+    QVector<EfsmVar> inputs;   // I
+    QVector<EfsmVar> outputs;  // O
+
+    void clear();
+
+    // Índice de adjacência: transições saindo de cada estado, já ordenadas
+    // por (prioridade, id) — a primeira habilitada é a escolhida.
+    // Chame rebuildIndex() depois de mexer em states/transitions à mão,
+    // ou use as edições incrementais abaixo, que o mantêm sozinhas.
+    void rebuildIndex();
+    const QVector<int>& outgoing(int state) const;
+
+    int  addTransition(const EfsmTransition& t);   // índice da nova transição
+    void removeTransition(int t);                  // a última passa a ocupar o índice t
+    void setTransitionPriority(int t, int priority);
+
+    int initialState() const;                  // -1 se não houver
+    int stateIndex(const QString& name) const; // -1 se não existir
+
+    // (de)serialização — mesmo formato do "Salvar…" da GUI
+    QJsonObject toJson() const;
+    bool fromJson(const QJsonObject& root, QString* error = nullptr);
+
+    // valor <-> JSON (bool, número inteiro ou string)
+    static QJsonValue encodeJsonValue(const EfsmValue& v);
+    static EfsmValue  decodeJsonValue(const QJsonValue& v);
+
+private:
+    bool firesBefore(int a, int b) const;   // ordem (prioridade, id)
+    void indexInsert(int t);
+    void indexErase(int t);
+
+    QVector<QVector<int>> outgoing_;
+};
@@ -0,0 +1,310 @@
+#include "EfsmReplay.h"
+#include <QFileDevice>
+#include <QIODevice>
+#include <QElapsedTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+// Fila limitada entre dois estágios; push() bloqueia cheia, pop() vazia.
+// close() acorda todos: pop() devolve false quando fechada e vazia.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(int capacity) : capacity_(qMax(1, capacity)) {}
+
+    bool push(T&& item){
+        std::unique_lock<std::mutex> lock(m_);
+        if ((int)q_.size() >= capacity_ && !closed_){
+            ++stats_.producerWaits;
+            QElapsedTimer t; t.start();
+            notFull_.wait(lock, [this]{ return (int)q_.size() < capacity_ || closed_; });
+            stats_.producerWaitMs += t.elapsed();
+        }
+        if (closed_) return false;   // consumidor desistiu
+        q_.push_back(std::move(item));
+        stats_.maxDepth = qMax(stats_.maxDepth, (int)q_.size());
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    bool pop(T& item){
+        std::unique_lock<std::mutex> lock(m_);
+        if (q_.empty() && !closed_){
+            ++stats_.consumerWaits;
+            QElapsedTimer t; t.start();
+            notEmpty_.wait(lock, [this]{ return !q_.empty() || closed_; });
+            stats_.consumerWaitMs += t.elapsed();
+        }
+        if (q_.empty()) return false;
+        item = std::move(q_.front());
+        q_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+    void close(){
+        std::lock_guard<std::mutex> lock(m_);
+        closed_ = true;
+        notFull_.notify_all();
+        notEmpty_.notify_all();
+    }
+
+    EfsmReplay::QueueStats stats(){
+        std::lock_guard<std::mutex> lock(m_);
+        return stats_;
+    }
+
+private:
+    const int capacity_;
+    std::mutex m_;
+    std::condition_variable notFull_, notEmpty_;
+    std::deque<T> q_;
+    bool closed_ = false;
+    EfsmReplay::QueueStats stats_;
+};
+
+// Linha de entrada já resolvida: (índice em I, valor)
+struct InputRow {
+    qint64 line = 0;
+    QVector<QPair<int, EfsmValue>> values;
+};
+
+struct ParsedBatch {
+    QVector<InputRow> rows;
+    qint64 badRows = 0;
+};
+
+// Uma transição disparada, só com o que mudou
+struct StepRecord {
+    qint64 row = 0;
+    int state = -1;
+    QVector<QPair<int, EfsmValue>> vars, outputs;
+};
+
+using OutBatch = QVector<StepRecord>;
+
+// CSV simples: vírgula, aspas duplas ("" escapa aspas)
+QStringList splitCsv(const QString& line){
+    QStringList out;
+    QString cur;
+    bool quoted = false;
+    for (int i=0; i<line.size(); ++i){
+        const QChar c = line[i];
+        if (quoted){
+            if (c == '"'){
+                if (i+1 < line.size() && line[i+1] == '"') { cur += '"'; ++i; }
+                else quoted = false;
+            } else cur += c;
+        } else if (c == '"') quoted = true;
+        else if (c == ',') { out << cur; cur.clear(); }
+        else cur += c;
+    }
+    out << cur;
+    return out;
+}
+
+void readStage(QIODevice& in, const EfsmModel& model, const EfsmReplay::Options& opt,
+               BoundedQueue<ParsedBatch>& q, std::atomic<qint64>& bytesRead){
+    QHash<QString, int> inputIdx;
+    for (int i=0; i<model.inputs.size(); ++i) inputIdx.insert(model.inputs[i].name, i);
+
+    EfsmReplay::Format fmt = opt.format;
+    QVector<int> columns;          // CSV: coluna -> índice em I (-1 = ignorada)
+    bool haveHeader = false;
+    qint64 lineNo = 0;
+
+    ParsedBatch batch;
+    batch.rows.reserve(opt.batchRows);
+    auto flush = [&](){
+        if (batch.rows.isEmpty() && batch.badRows == 0) return true;
+        const bool ok = q.push(std::move(batch));
+        batch = ParsedBatch();
+        batch.rows.reserve(opt.batchRows);
+        return ok;
+    };
+
+    while (!in.atEnd()){
+        const QByteArray raw = in.readLine();
+        bytesRead.fetch_add(raw.size(), std::memory_order_relaxed);
+        ++lineNo;
+        const QByteArray line = raw.trimmed();
+        if (line.isEmpty()) continue;
+
+        if (fmt == EfsmReplay::Format::Auto)
+            fmt = line.startsWith('{') ? EfsmReplay::Format::Jsonl : EfsmReplay::Format::Csv;
+
+        InputRow row;
+        row.line = lineNo;
+        if (fmt == EfsmReplay::Format::Csv){
+            const QStringList cells = splitCsv(QString::fromUtf8(line));
+            if (!haveHeader){
+                for (const auto& name : cells) columns.push_back(inputIdx.value(name.trimmed(), -1));
+                haveHeader = true;
+                continue;
+            }
+            if (cells.size() != columns.size()) { ++batch.badRows; continue; }
+            for (int c=0; c<cells.size(); ++c)
+                if (columns[c] >= 0) row.values.push_back({ columns[c], EfsmValue::parse(cells[c]) });
+        } else {
+            QJsonParseError err;
+            const QJsonDocument doc = QJsonDocument::fromJson(line, &err);
+            if (err.error != QJsonParseError::NoError || !doc.isObject()) { ++batch.badRows; continue; }
+            const QJsonObject o = doc.object();
+            for (auto it = o.begin(); it != o.end(); ++it){
+                const int k = inputIdx.value(it.key(), -1);
+                if (k >= 0) row.values.push_back({ k, EfsmModel::decodeJsonValue(it.value()) });
+            }
+        }
+        batch.rows.push_back(std::move(row));
+        if (batch.rows.size() >= opt.batchRows && !flush()) return;   // passo encerrou
+    }
+    flush();
+}
+
+// Devolve false (com o motivo em error) se a saída recusou bytes; a fila é
+// fechada para que o passo pare no próximo push.
+bool writeStage(QIODevice& out, const EfsmModel& model, BoundedQueue<OutBatch>& q,
+                qint64& bytes, QString& error){
+    auto varsJson = [](const QVector<EfsmVar>& decl, const QVector<QPair<int, EfsmValue>>& vals){
+        QJsonObject o;
+        for (const auto& p : vals) o.insert(decl[p.first].name, EfsmModel::encodeJsonValue(p.second));
+        return o;
+    };
+    OutBatch batch;
+    QByteArray buf;
+    while (q.pop(batch)){
+        buf.clear();
+        for (const StepRecord& r : batch){
+            QJsonObject o;
+            o["row"]   = (double)r.row;
+            o["state"] = r.state >= 0 ? model.states[r.state].name : QString();
+            if (!r.vars.isEmpty())    o["x"] = varsJson(model.vars, r.vars);
+            if (!r.outputs.isEmpty()) o["o"] = varsJson(model.outputs, r.outputs);
+            buf += QJsonDocument(o).toJson(QJsonDocument::Compact);
+            buf += '\n';
+        }
+        const qint64 n = out.write(buf);
+        if (n != buf.size()){
+            error = out.errorString().isEmpty() ? QString("escrita incompleta") : out.errorString();
+            if (n > 0) bytes += n;
+            q.close();
+            return false;
+        }
+        bytes += n;
+    }
+    // QFile guarda em buffer: o erro de disco cheio pode só aparecer aqui
+    if (auto* f = qobject_cast<QFileDevice*>(&out)){
+        if (!f->flush()){
+            error = f->errorString();
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+EfsmReplay::Stats EfsmReplay::run(const EfsmModel& model, QIODevice& in, QIODevice& out,
+                                  const Options& options, const ProgressFn& progress,
+                                  const std::atomic<bool>* cancel){
+    Stats st;
+    QElapsedTimer clock;
+    clock.start();
+
+    EfsmEngine engine(model);   // leitor/escritor só leem `model` (imutável)
+    BoundedQueue<ParsedBatch> parsedQ(options.queueBatches);
+    BoundedQueue<OutBatch>    outQ(options.queueBatches);
+
+    std::atomic<qint64> bytesRead{0};
+    std::thread reader([&](){ readStage(in, model, options, parsedQ, bytesRead); parsedQ.close(); });
+    qint64 bytes = 0;
+    QString writeError;
+    std::thread writer([&](){ writeStage(out, model, outQ, bytes, writeError); });
+
+    // Estágio do meio: aplica I, dá o passo e registra o que mudou
+    ParsedBatch batch;
+    OutBatch pending;
+    pending.reserve(options.batchRows);
+    bool stop = false;
+    if (options.stopAtFinal && engine.isFinal()) { st.reachedFinal = true; stop = true; }
+    while (!stop && parsedQ.pop(batch)){
+        if (cancel && cancel->load(std::memory_order_relaxed)) { st.cancelled = true; break; }
+        st.badRows += batch.badRows;
+        for (const InputRow& row : batch.rows){
+            for (const auto& p : row.values) engine.setInput(p.first, p.second);
+            ++st.rows;
+            const EfsmEngine::StepResult r = engine.step();
+            st.lastStatus = r.status;
+            if (r.status == EfsmEngine::StepStatus::NoneEnabled) { ++st.blocked; continue; }
+            if (r.status != EfsmEngine::StepStatus::Fired){
+                if (r.status == EfsmEngine::StepStatus::ActionError)
+                    st.error = QString("linha %1: %2").arg(row.line).arg(r.error);
+                stop = true;   // sem estado / sem saídas: o restante não muda nada
+                break;
+            }
+            ++st.steps;
+            StepRecord rec;
+            rec.row = row.line;
+            rec.state = engine.currentState();
+            for (int k : r.changedVars)    rec.vars.push_back({ k, engine.var(k) });
+            for (int k : r.changedOutputs) rec.outputs.push_back({ k, engine.output(k) });
+            pending.push_back(std::move(rec));
+            if (pending.size() >= options.batchRows){
+                if (!outQ.push(std::move(pending))) { stop = true; break; }   // escrita falhou
+                pending = OutBatch();
+                pending.reserve(options.batchRows);
+            }
+            if (options.stopAtFinal && engine.isFinal()) { st.reachedFinal = true; stop = true; break; }
+        }
+        if (progress){
+            Progress p;
+            p.rows = st.rows;
+            p.steps = st.steps;
+            p.bytesRead = bytesRead.load(std::memory_order_relaxed);
+            progress(p);
+        }
+    }
+    if (!pending.isEmpty()) outQ.push(std::move(pending));   // false só se a escrita já falhou
+
+    parsedQ.close();   // leitor para no próximo push se ainda houver entrada
+    reader.join();
+    outQ.close();
+    writer.join();
+
+    st.finalState = engine.currentState();
+    st.vars       = engine.vars();
+    st.outputs    = engine.outputs();
+    st.bytesOut  = bytes;
+    st.writeError = writeError;
+    st.parsed    = parsedQ.stats();
+    st.written   = outQ.stats();
+    st.elapsedMs = clock.elapsed();
+    return st;
+}
+
+QString EfsmReplay::Stats::summary() const {
+    const qint64 ms = qMax<qint64>(1, elapsedMs);
+    auto queue = [](const char* name, const QueueStats& q){
+        return QString("%1: fila cheia %2× (%3 ms), vazia %4× (%5 ms), pico %6 lotes")
+            .arg(name).arg(q.producerWaits).arg(q.producerWaitMs)
+            .arg(q.consumerWaits).arg(q.consumerWaitMs).arg(q.maxDepth);
+    };
+    QStringList lines;
+    lines << QString("%1 linhas em %2 ms (%3 linhas/s)").arg(rows).arg(elapsedMs).arg(rows*1000/ms);
+    lines << QString("%1 transições, %2 linhas sem transição habilitada, %3 linhas inválidas")
+                 .arg(steps).arg(blocked).arg(badRows);
+    lines << QString("%1 bytes escritos").arg(bytesOut);
+    lines << queue("leitura → passo", parsed);
+    lines << queue("passo → escrita", written);
+    if (reachedFinal) lines << "parou no estado final";
+    if (cancelled) lines << "cancelada";
+    if (!error.isEmpty()) lines << "erro: " + error;
+    if (!writeError.isEmpty()) lines << "erro de escrita (saída incompleta): " + writeError;
+    return lines.join('\n');
+}
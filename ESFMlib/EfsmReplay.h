@@ -0,0 +1,74 @@
+#pragma once
+#include "EfsmEngine.h"
+#include <atomic>
+#include <functional>
+
+class QIODevice;
+
+// Reprodução de um roteiro de inputs gravado (CSV ou JSONL), em streaming.
+// Três estágios ligados por filas limitadas:
+//   leitura/parse (thread) -> passo do engine (thread chamadora) -> escrita (thread)
+// As linhas trafegam em lotes; com as filas cheias o estágio anterior
+// espera (backpressure), então a memória não depende do tamanho do roteiro.
+//
+// Entrada CSV: a primeira linha nomeia as colunas (nomes de I); colunas
+// desconhecidas são ignoradas. JSONL: um objeto {"nome": valor, …} por linha.
+// Cada linha é aplicada a I (só as colunas presentes) e dispara um passo.
+//
+// Saída JSONL, uma linha por transição disparada, só com o que mudou:
+//   {"row":12,"state":"S2","x":{"n":3},"o":{"led":true}}
+//
+// Falha de escrita (disco cheio, dispositivo fechado) fecha as filas e
+// encerra os três estágios; o motivo fica em Stats::writeError e a saída
+// deve ser tratada como truncada.
+class EfsmReplay {
+public:
+    enum class Format { Auto, Csv, Jsonl };   // Auto: '{' na primeira linha => JSONL
+
+    struct Options {
+        Format format = Format::Auto;
+        int batchRows = 256;       // linhas por lote entre estágios
+        int queueBatches = 16;     // capacidade de cada fila, em lotes
+        bool stopAtFinal = false;  // encerra ao entrar num estado final
+    };
+
+    struct QueueStats {
+        qint64 producerWaits = 0;  // vezes que a fila estava cheia (backpressure)
+        qint64 consumerWaits = 0;  // vezes que estava vazia (estágio seguinte ocioso)
+        qint64 producerWaitMs = 0;
+        qint64 consumerWaitMs = 0;
+        int maxDepth = 0;          // em lotes
+    };
+
+    struct Stats {
+        qint64 rows = 0;           // linhas de entrada aplicadas
+        qint64 badRows = 0;        // linhas que não puderam ser lidas (puladas)
+        qint64 steps = 0;          // transições disparadas
+        qint64 blocked = 0;        // linhas sem transição habilitada
+        qint64 bytesOut = 0;
+        qint64 elapsedMs = 0;
+        EfsmEngine::StepStatus lastStatus = EfsmEngine::StepStatus::Fired;
+        bool reachedFinal = false;
+        bool cancelled = false;
+        QString error;             // erro de ação/entrada que encerrou a reprodução
+        QString writeError;        // saída incompleta: escrita falhou
+        int finalState = -1;       // configuração ao terminar
+        QVector<EfsmValue> vars, outputs;
+        QueueStats parsed;         // leitura -> passo
+        QueueStats written;        // passo -> escrita
+        QString summary() const;   // texto de uma linha por item, para logs/diálogos
+    };
+
+    struct Progress {
+        qint64 rows = 0;
+        qint64 steps = 0;
+        qint64 bytesRead = 0;      // da entrada; size() da entrada dá o total
+    };
+    using ProgressFn = std::function<void(const Progress&)>;   // a cada lote, da thread chamadora
+
+    // Reproduz a partir do estado inicial e valuations do modelo.
+    static Stats run(const EfsmModel& model, QIODevice& in, QIODevice& out,
+                     const Options& options = Options(),
+                     const ProgressFn& progress = ProgressFn(),
+                     const std::atomic<bool>* cancel = nullptr);
+};
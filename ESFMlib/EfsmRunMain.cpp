@@ -0,0 +1,257 @@
+// efsm-run: executa um modelo salvo (.json) sem GUI, para regressões em CI.
+//
+//   efsm-run modelo.json -t roteiro.csv -o saida.jsonl -s resumo.json
+//   efsm-run modelo.json -n 100000 --no-stop-at-final
+//   efsm-run modelo.json --scenarios suite.json -j 8
+//
+// Roteiro: CSV/JSONL de inputs, uma linha por passo (EfsmReplay); a saída é
+// o JSONL de mudanças em X/O do "Reproduzir…". Sem roteiro: N passos com os
+// inputs do modelo, mesma saída com "step" no lugar de "row". Cenários: o
+// JSON do "Lote…" (EfsmBatch), um resultado por cenário no resumo.
+//
+// O resumo (JSON) vai para -s ou para a saída padrão. Código de saída: 0 ok,
+// 1 erro de uso/arquivo (inclusive falha ao escrever a saída), 2 alguma
+// execução terminou com erro de ação.
+#include "EfsmBatch.h"
+#include "EfsmReplay.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cstdio>
+
+namespace {
+
+// destino de "-o" omitido: a reprodução precisa de um dispositivo
+class NullDevice : public QIODevice {
+public:
+    NullDevice() { open(QIODevice::WriteOnly); }
+protected:
+    qint64 readData(char*, qint64) override { return -1; }
+    qint64 writeData(const char*, qint64 len) override { return len; }
+};
+
+const char* statusName(EfsmEngine::StepStatus s){
+    switch (s){
+    case EfsmEngine::StepStatus::Fired:          return "fired";
+    case EfsmEngine::StepStatus::NoCurrentState: return "no-current-state";
+    case EfsmEngine::StepStatus::NoOutgoing:     return "no-outgoing";
+    case EfsmEngine::StepStatus::NoneEnabled:    return "none-enabled";
+    case EfsmEngine::StepStatus::ActionError:    return "action-error";
+    }
+    return "";
+}
+
+QJsonObject valuesJson(const QVector<EfsmVar>& decl, const QVector<EfsmValue>& values){
+    QJsonObject o;
+    for (int k=0; k<decl.size() && k<values.size(); ++k)
+        o.insert(decl[k].name, EfsmModel::encodeJsonValue(values[k]));
+    return o;
+}
+
+QString stateName(const EfsmModel& m, int s){
+    return s >= 0 && s < m.states.size() ? m.states[s].name : QString();
+}
+
+int fail(const QString& message){
+    std::fprintf(stderr, "efsm-run: %s\n", qPrintable(message));
+    return 1;
+}
+
+bool openOut(QFile& f, const QString& path){
+    if (path == "-") return f.open(stdout, QIODevice::WriteOnly);
+    return f.open(QIODevice::WriteOnly | QIODevice::Truncate);
+}
+
+// N passos, um de cada vez, escrevendo o que mudou a cada transição
+QJsonObject runSteps(const EfsmModel& model, qint64 maxSteps, bool stopAtFinal, QIODevice& out, bool& actionError){
+    QElapsedTimer clock;
+    clock.start();
+    EfsmEngine e(model);
+    qint64 steps = 0;
+    EfsmEngine::StepResult r;
+    r.status = EfsmEngine::StepStatus::Fired;
+    bool reachedFinal = stopAtFinal && e.isFinal();
+    QByteArray buf;
+    bool written = true;
+    while (!reachedFinal && steps < maxSteps){
+        r = e.step();
+        if (r.status != EfsmEngine::StepStatus::Fired) break;
+        ++steps;
+        QJsonObject o;
+        o["step"] = double(steps);
+        o["state"] = stateName(model, e.currentState());
+        if (!r.changedVars.isEmpty()){
+            QJsonObject x;
+            for (int k : r.changedVars) x.insert(model.vars[k].name, EfsmModel::encodeJsonValue(e.var(k)));
+            o["x"] = x;
+        }
+        if (!r.changedOutputs.isEmpty()){
+            QJsonObject ov;
+            for (int k : r.changedOutputs) ov.insert(model.outputs[k].name, EfsmModel::encodeJsonValue(e.output(k)));
+            o["o"] = ov;
+        }
+        buf += QJsonDocument(o).toJson(QJsonDocument::Compact);
+        buf += '\n';
+        if (buf.size() >= (1 << 16)){
+            if (out.write(buf) != buf.size()) { written = false; break; }   // writeError no resumo
+            buf.clear();
+        }
+        reachedFinal = stopAtFinal && e.isFinal();
+    }
+    if (written && !buf.isEmpty()) written = out.write(buf) == buf.size();
+    actionError = r.status == EfsmEngine::StepStatus::ActionError;
+
+    const auto& gs = e.guardStats();
+    QJsonObject s;
+    s["mode"] = "steps";
+    s["steps"] = double(steps);
+    s["status"] = statusName(r.status);
+    s["reachedFinal"] = reachedFinal;
+    if (actionError) s["error"] = r.error;
+    if (!r.guardError.isEmpty()) s["guardError"] = r.guardError;
+    s["finalState"] = stateName(model, e.currentState());
+    s["x"] = valuesJson(model.vars, e.vars());
+    s["o"] = valuesJson(model.outputs, e.outputs());
+    s["guardsEvaluated"] = double(gs.evaluated);
+    s["guardsCached"] = double(gs.cached);
+    s["elapsedMs"] = double(clock.elapsed());
+    if (!written) s["writeError"] = out.errorString().isEmpty() ? QString("escrita incompleta") : out.errorString();
+    return s;
+}
+
+} // namespace
+
+int main(int argc, char** argv){
+    QCoreApplication app(argc, argv);   // sem GUI: QJSEngine só precisa do núcleo
+    QCoreApplication::setApplicationName("efsm-run");
+
+    QCommandLineParser p;
+    p.setApplicationDescription("Executa um modelo EFSM salvo (.json) sem interface gráfica.");
+    p.addHelpOption();
+    p.addPositionalArgument("modelo", "Modelo salvo pelo EFSM Studio (.json).");
+    const QCommandLineOption traceOpt({ "t", "trace" }, "Roteiro de inputs CSV/JSONL (um passo por linha).", "arquivo");
+    const QCommandLineOption stepsOpt({ "n", "steps" }, "Passos sem roteiro (padrão 1000).", "N", "1000");
+    const QCommandLineOption scenariosOpt("scenarios", "Cenários JSON do Lote… (um resultado por cenário).", "arquivo");
+    const QCommandLineOption threadsOpt({ "j", "threads" }, "Threads para --scenarios (padrão: todas).", "N", "0");
+    const QCommandLineOption outOpt({ "o", "output" }, "JSONL de mudanças em X/O (\"-\" = saída padrão).", "arquivo");
+    const QCommandLineOption summaryOpt({ "s", "summary" }, "Resumo JSON (padrão: saída padrão).", "arquivo", "-");
+    const QCommandLineOption noFinalOpt("no-stop-at-final", "Não para ao entrar num estado final.");
+    p.addOptions({ traceOpt, stepsOpt, scenariosOpt, threadsOpt, outOpt, summaryOpt, noFinalOpt });
+    p.process(app);
+
+    if (p.positionalArguments().size() != 1) { p.showHelp(1); }
+    const QString modelPath = p.positionalArguments().front();
+    if (p.isSet(traceOpt) + p.isSet(scenariosOpt) + p.isSet(stepsOpt) > 1)
+        return fail("use só um de --trace, --steps e --scenarios");
+    if (p.value(outOpt) == "-" && p.value(summaryOpt) == "-")
+        return fail("--output e --summary não podem ir ambos para a saída padrão");
+
+    // modelo
+    QElapsedTimer clock;
+    clock.start();
+    QFile mf(modelPath);
+    if (!mf.open(QIODevice::ReadOnly)) return fail(modelPath + ": " + mf.errorString());
+    QJsonParseError perr;
+    const QJsonDocument doc = QJsonDocument::fromJson(mf.readAll(), &perr);
+    EfsmModel model;
+    QString err;
+    if (!doc.isObject()) return fail(modelPath + ": " + perr.errorString());
+    if (!model.fromJson(doc.object(), &err)) return fail(modelPath + ": " + err);
+    model.rebuildIndex();
+    const qint64 loadMs = clock.elapsed();
+    const bool stopAtFinal = !p.isSet(noFinalOpt);
+
+    // saída de passos
+    QFile outFile;
+    NullDevice nullOut;
+    QIODevice* out = &nullOut;
+    if (p.isSet(outOpt)){
+        outFile.setFileName(p.value(outOpt));
+        if (!openOut(outFile, p.value(outOpt))) return fail(p.value(outOpt) + ": " + outFile.errorString());
+        out = &outFile;
+    }
+
+    QJsonObject summary;
+    bool actionError = false;
+    if (p.isSet(traceOpt)){
+        QFile in(p.value(traceOpt));
+        if (!in.open(QIODevice::ReadOnly)) return fail(in.fileName() + ": " + in.errorString());
+        EfsmReplay::Options opt;
+        opt.stopAtFinal = stopAtFinal;
+        const EfsmReplay::Stats st = EfsmReplay::run(model, in, *out, opt);
+        actionError = st.lastStatus == EfsmEngine::StepStatus::ActionError;
+        summary["mode"] = "trace";
+        summary["trace"] = in.fileName();
+        summary["rows"] = double(st.rows);
+        summary["badRows"] = double(st.badRows);
+        summary["blocked"] = double(st.blocked);
+        summary["steps"] = double(st.steps);
+        summary["status"] = statusName(st.lastStatus);
+        summary["reachedFinal"] = st.reachedFinal;
+        if (!st.error.isEmpty()) summary["error"] = st.error;
+        if (!st.writeError.isEmpty()) summary["writeError"] = st.writeError;
+        summary["finalState"] = stateName(model, st.finalState);
+        summary["x"] = valuesJson(model.vars, st.vars);
+        summary["o"] = valuesJson(model.outputs, st.outputs);
+        summary["elapsedMs"] = double(st.elapsedMs);
+    } else if (p.isSet(scenariosOpt)){
+        QFile sf(p.value(scenariosOpt));
+        if (!sf.open(QIODevice::ReadOnly)) return fail(sf.fileName() + ": " + sf.errorString());
+        const QJsonDocument sdoc = QJsonDocument::fromJson(sf.readAll(), &perr);
+        QVector<EfsmScenario> scenarios;
+        if (sdoc.isNull()) return fail(sf.fileName() + ": " + perr.errorString());
+        const QJsonValue root = sdoc.isArray() ? QJsonValue(sdoc.array()) : QJsonValue(sdoc.object());
+        if (!EfsmBatch::scenariosFromJson(root, scenarios, &err)) return fail(sf.fileName() + ": " + err);
+
+        QElapsedTimer runClock;
+        runClock.start();
+        const QVector<EfsmScenarioResult> results = EfsmBatch::run(model, scenarios, p.value(threadsOpt).toInt());
+        QJsonArray arr;
+        int failed = 0;
+        for (const auto& r : results){
+            QJsonObject o;
+            o["name"] = r.name;
+            o["steps"] = double(r.steps);
+            o["status"] = statusName(r.status);
+            o["reachedFinal"] = r.reachedFinal;
+            if (!r.error.isEmpty()) o["error"] = r.error;
+            o["finalState"] = stateName(model, r.finalState);
+            o["x"] = valuesJson(model.vars, r.vars);
+            o["o"] = valuesJson(model.outputs, r.outputs);
+            arr.push_back(o);
+            if (r.status == EfsmEngine::StepStatus::ActionError) ++failed;
+        }
+        actionError = failed > 0;
+        summary["mode"] = "scenarios";
+        summary["scenarios"] = arr;
+        summary["failed"] = failed;
+        summary["elapsedMs"] = double(runClock.elapsed());
+    } else {
+        bool ok = false;
+        const qint64 n = p.value(stepsOpt).toLongLong(&ok);
+        if (!ok || n < 0) return fail("--steps inválido: " + p.value(stepsOpt));
+        summary = runSteps(model, n, stopAtFinal, *out, actionError);
+    }
+    QString writeError = summary.value("writeError").toString();
+    if (out == &outFile){
+        if (!outFile.flush() && writeError.isEmpty()) writeError = outFile.errorString();
+        outFile.close();
+    }
+    if (!writeError.isEmpty()) summary["writeError"] = writeError;
+
+    summary["model"] = modelPath;
+    summary["loadMs"] = double(loadMs);
+    QFile sumFile;
+    sumFile.setFileName(p.value(summaryOpt));
+    if (!openOut(sumFile, p.value(summaryOpt))) return fail(p.value(summaryOpt) + ": " + sumFile.errorString());
+    const QByteArray sumJson = QJsonDocument(summary).toJson(QJsonDocument::Indented);
+    if (sumFile.write(sumJson) != sumJson.size() || !sumFile.flush())
+        return fail(p.value(summaryOpt) + ": " + sumFile.errorString());
+    sumFile.close();
+    if (!writeError.isEmpty()) return fail(p.value(outOpt) + ": " + writeError);
+    return actionError ? 2 : 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <QString>
+#include <QMetaType>
+
+// Valor tipado de uma variável do EFSM (X/I/O): bool, inteiro de 64 bits
+// ou string. Engine, VM e tabelas guardam EfsmValue; texto só aparece na
+// exibição/edição da célula e na persistência.
+struct EfsmValue {
+    enum Type : quint8 { Bool, Int, String };
+    qint64  i = 0;          // Bool (0/1) e Int
+    QString s;              // String
+    Type type = String;     // padrão: string vazia (linha recém-criada)
+
+    static EfsmValue fromBool(bool b)  { EfsmValue v; v.i = b ? 1 : 0; v.type = Bool; return v; }
+    static EfsmValue fromInt(qint64 n) { EfsmValue v; v.i = n; v.type = Int; return v; }
+    static EfsmValue fromString(const QString& str) { EfsmValue v; v.s = str; return v; }
+
+    // "true"/"false" (sem caixa), inteiro, senão string livre
+    static EfsmValue parse(const QString& text){
+        const QString t = text.trimmed();
+        if (t.compare("true", Qt::CaseInsensitive)==0)  return fromBool(true);
+        if (t.compare("false", Qt::CaseInsensitive)==0) return fromBool(false);
+        bool ok=false; const qlonglong n = t.toLongLong(&ok);
+        if (ok) return fromInt(n);
+        return fromString(t);
+    }
+    QString toString() const {
+        switch (type){
+        case Bool: return i ? QStringLiteral("true") : QStringLiteral("false");
+        case Int:  return QString::number(i);
+        default:   return s;
+        }
+    }
+
+    bool isBool()   const { return type == Bool; }
+    bool isInt()    const { return type == Int; }
+    bool isString() const { return type == String; }
+    bool truthy() const { return type == String ? !s.isEmpty() : i != 0; }
+
+    bool operator==(const EfsmValue& o) const {
+        return type == o.type && (type == String ? s == o.s : i == o.i);
+    }
+    bool operator!=(const EfsmValue& o) const { return !(*this == o); }
+};
+Q_DECLARE_METATYPE(EfsmValue)
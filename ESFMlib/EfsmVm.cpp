@@ -0,0 +1,441 @@
+#include "EfsmVm.h"
+#include <QVarLengthArray>
+#include <QPair>
+#include <QStringList>
+#include <cstdlib>      // std::llabs
+
+namespace {
+
+constexpr qint64 kMaxSafe = qint64(1) << 53;   // inteiros exatos num double JS
+
+bool safe(qint64 n) { return n >= -kMaxSafe && n <= kMaxSafe; }
+
+// ===== léxico =====
+struct Token {
+    enum Kind { End, Num, Ident, Sym, Error } kind = End;
+    QString text;
+    qint64 num = 0;
+    bool newlineBefore = false;
+};
+
+class Lexer {
+public:
+    explicit Lexer(const QString& s) : s_(s) {}
+
+    Token next(){
+        Token t;
+        while (pos_ < s_.size() && s_[pos_].isSpace()){
+            if (s_[pos_] == '\n') t.newlineBefore = true;
+            ++pos_;
+        }
+        if (pos_ >= s_.size()) { t.kind = Token::End; return t; }
+
+        const QChar c = s_[pos_];
+        if (c.isDigit()){
+            const int start = pos_;
+            while (pos_ < s_.size() && s_[pos_].isDigit()) ++pos_;
+            // "1.5", "1e3", "0x10"…: fora do subconjunto
+            if (pos_ < s_.size() && (s_[pos_].isLetterOrNumber() || s_[pos_] == '.' || s_[pos_] == '_')) {
+                t.kind = Token::Error; return t;
+            }
+            bool ok = false;
+            t.num = s_.mid(start, pos_-start).toLongLong(&ok);
+            t.kind = (ok && safe(t.num)) ? Token::Num : Token::Error;
+            return t;
+        }
+        if (c.isLetter() || c == '_' || c == '$'){
+            const int start = pos_;
+            while (pos_ < s_.size() && (s_[pos_].isLetterOrNumber() || s_[pos_] == '_' || s_[pos_] == '$')) ++pos_;
+            t.kind = Token::Ident;
+            t.text = s_.mid(start, pos_-start);
+            return t;
+        }
+
+        // símbolos, do mais longo para o mais curto
+        static const char* const syms[] = {
+            "===", "!==", "==", "!=", "<=", ">=", "&&", "||", ":=",
+            "=", "<", ">", "!", "+", "-", "*", "%", "(", ")", ";"
+        };
+        for (const char* sym : syms){
+            const int len = int(qstrlen(sym));
+            if (!matches(sym, len)) continue;
+            // "++", "--", "+=" etc. não fazem parte do subconjunto
+            const int after = pos_ + len;
+            if (len == 1 && qstrchr("+-*%", sym[0]) && after < s_.size()
+                && (s_[after] == QLatin1Char(sym[0]) || s_[after] == QLatin1Char('=')))
+                break;
+            pos_ = after;
+            t.kind = Token::Sym;
+            t.text = QLatin1String(sym);
+            return t;
+        }
+        t.kind = Token::Error;
+        return t;
+    }
+
+private:
+    bool matches(const char* sym, int len) const {
+        if (pos_ + len > s_.size()) return false;
+        for (int k=0; k<len; ++k)
+            if (s_[pos_+k] != QLatin1Char(sym[k])) return false;
+        return true;
+    }
+
+    const QString& s_;
+    int pos_ = 0;
+};
+
+// ===== parser + gerador (descendente recursivo, precedência do JS) =====
+class Compiler {
+public:
+    Compiler(const QString& src, const EfsmVm::Resolver& r, EfsmVm::Program& p)
+        : lex_(src), resolve_(r), p_(p) { advance(); }
+
+    bool guard(){
+        p_.isGuard = true;
+        if (!expr()) return false;
+        while (isSym(";")) advance();
+        return tok_.kind == Token::End;
+    }
+
+    bool action(){
+        p_.isGuard = false;
+        for (;;){
+            while (isSym(";")) advance();
+            if (tok_.kind == Token::End) return true;
+            if (!assignment()) return false;
+            // fim de instrução: ';', fim do texto ou quebra de linha
+            if (!(isSym(";") || tok_.kind == Token::End || tok_.newlineBefore)) return false;
+        }
+    }
+
+private:
+    void advance(){ tok_ = lex_.next(); }
+    bool isSym(const char* s) const { return tok_.kind == Token::Sym && tok_.text == QLatin1String(s); }
+
+    void put(EfsmVm::Op op, qint32 arg, int stackDelta){
+        p_.code.push_back({ op, arg });
+        depth_ += stackDelta;
+        if (depth_ > p_.maxStack) p_.maxStack = depth_;
+    }
+
+    static void addUnique(QVector<int>& v, int slot){ if (!v.contains(slot)) v.push_back(slot); }
+
+    bool assignment(){
+        if (tok_.kind != Token::Ident) return false;
+        const int slot = resolve_(tok_.text, true);
+        if (slot < 0) return false;
+        advance();
+        if (!(isSym(":=") || isSym("="))) return false;
+        advance();
+        if (!expr()) return false;
+        put(EfsmVm::Store, slot, -1);
+        addUnique(p_.writes, slot);
+        return true;
+    }
+
+    bool expr() { return orExpr(); }
+
+    bool orExpr(){
+        if (!andExpr()) return false;
+        while (isSym("||")){
+            advance();
+            const int at = p_.code.size();
+            put(EfsmVm::JumpIfTrueKeep, 0, -1);   // caminho "continua" descarta
+            if (!andExpr()) return false;
+            p_.code[at].arg = p_.code.size();
+        }
+        return true;
+    }
+
+    bool andExpr(){
+        if (!eqExpr()) return false;
+        while (isSym("&&")){
+            advance();
+            const int at = p_.code.size();
+            put(EfsmVm::JumpIfFalseKeep, 0, -1);
+            if (!eqExpr()) return false;
+            p_.code[at].arg = p_.code.size();
+        }
+        return true;
+    }
+
+    bool eqExpr(){
+        if (!relExpr()) return false;
+        for (;;){
+            EfsmVm::Op op;
+            if      (isSym("==="))  op = EfsmVm::StrictEq;
+            else if (isSym("!=="))  op = EfsmVm::StrictNe;
+            else if (isSym("=="))   op = EfsmVm::Eq;
+            else if (isSym("!="))   op = EfsmVm::Ne;
+            else return true;
+            advance();
+            if (!relExpr()) return false;
+            put(op, 0, -1);
+        }
+    }
+
+    bool relExpr(){
+        if (!addExpr()) return false;
+        for (;;){
+            EfsmVm::Op op;
+            if      (isSym("<="))  op = EfsmVm::Le;
+            else if (isSym(">="))  op = EfsmVm::Ge;
+            else if (isSym("<"))   op = EfsmVm::Lt;
+            else if (isSym(">"))   op = EfsmVm::Gt;
+            else return true;
+            advance();
+            if (!addExpr()) return false;
+            put(op, 0, -1);
+        }
+    }
+
+    bool addExpr(){
+        if (!mulExpr()) return false;
+        for (;;){
+            EfsmVm::Op op;
+            if      (isSym("+")) op = EfsmVm::Add;
+            else if (isSym("-")) op = EfsmVm::Sub;
+            else return true;
+            advance();
+            if (!mulExpr()) return false;
+            put(op, 0, -1);
+        }
+    }
+
+    bool mulExpr(){
+        if (!unary()) return false;
+        for (;;){
+            EfsmVm::Op op;
+            if      (isSym("*")) op = EfsmVm::Mul;
+            else if (isSym("%")) op = EfsmVm::Mod;
+            else return true;   // "/" não está no subconjunto (JS dá fração)
+            advance();
+            if (!unary()) return false;
+            put(op, 0, -1);
+        }
+    }
+
+    bool unary(){
+        EfsmVm::Op op;
+        if      (isSym("!")) op = EfsmVm::Not;
+        else if (isSym("-")) op = EfsmVm::Neg;
+        else if (isSym("+")) op = EfsmVm::Plus;
+        else return primary();
+        advance();
+        if (!unary()) return false;
+        put(op, 0, 0);
+        return true;
+    }
+
+    bool primary(){
+        if (tok_.kind == Token::Num){
+            p_.consts.push_back(EfsmValue::fromInt(tok_.num));
+            put(EfsmVm::PushConst, p_.consts.size()-1, +1);
+            advance();
+            return true;
+        }
+        if (tok_.kind == Token::Ident){
+            if (tok_.text == QLatin1String("true") || tok_.text == QLatin1String("false")){
+                p_.consts.push_back(EfsmValue::fromBool(tok_.text == QLatin1String("true")));
+                put(EfsmVm::PushConst, p_.consts.size()-1, +1);
+                advance();
+                return true;
+            }
+            const int slot = resolve_(tok_.text, false);
+            if (slot < 0) return false;
+            advance();
+            if (isSym("(")) return false;   // chamada de função => JS
+            put(EfsmVm::Load, slot, +1);
+            addUnique(p_.reads, slot);
+            return true;
+        }
+        if (isSym("(")){
+            advance();
+            if (!expr()) return false;
+            if (!isSym(")")) return false;
+            advance();
+            return true;
+        }
+        return false;
+    }
+
+    Lexer lex_;
+    const EfsmVm::Resolver& resolve_;
+    EfsmVm::Program& p_;
+    Token tok_;
+    int depth_ = 0;
+};
+
+bool compileWith(const QString& text, const EfsmVm::Resolver& resolve,
+                 EfsmVm::Program& out, bool isGuard){
+    out = EfsmVm::Program{};
+    Compiler c(text, resolve, out);
+    out.valid = isGuard ? c.guard() : c.action();
+    if (!out.valid) out = EfsmVm::Program{};
+    return out.valid;
+}
+
+} // namespace
+
+bool EfsmVm::compileGuard(const QString& text, const Resolver& resolve, Program& out){
+    return compileWith(text, resolve, out, true);
+}
+
+bool EfsmVm::compileAction(const QString& text, const Resolver& resolve, Program& out){
+    return compileWith(text, resolve, out, false);
+}
+
+bool EfsmVm::readSet(const QString& text, const Resolver& resolve, QVector<int>& reads){
+    // palavras que não são nomes de variável (e não têm efeito colateral)
+    static const QStringList keywords = {
+        "true", "false", "null", "undefined", "NaN", "Infinity",
+        "typeof", "void", "in", "instanceof"
+    };
+    reads.clear();
+    const int n = text.size();
+    for (int i=0; i<n; ){
+        const QChar c = text[i];
+        if (c == '\'' || c == '"'){                  // literal de string
+            for (++i; i<n && text[i] != c; ++i) if (text[i] == '\\') ++i;
+            ++i;
+            continue;
+        }
+        if (c == '`') return false;                  // template: pode interpolar
+        if (c == '/' && i+1 < n && text[i+1] == '/'){
+            while (i<n && text[i] != '\n') ++i;
+            continue;
+        }
+        if (c == '/' && i+1 < n && text[i+1] == '*'){
+            const int end = text.indexOf("*/", i+2);
+            if (end < 0) return false;
+            i = end + 2;
+            continue;
+        }
+        if (c.isDigit()){
+            while (i<n && (text[i].isLetterOrNumber() || text[i] == '.' || text[i] == '_')) ++i;
+            continue;
+        }
+        if (c.isLetter() || c == '_' || c == '$'){
+            const int start = i;
+            while (i<n && (text[i].isLetterOrNumber() || text[i] == '_' || text[i] == '$')) ++i;
+            int prev = start - 1;
+            while (prev >= 0 && text[prev].isSpace()) --prev;
+            if (prev >= 0 && text[prev] == '.') continue;   // membro: conta só a base
+            int next = i;
+            while (next < n && text[next].isSpace()) ++next;
+            const QString name = text.mid(start, i-start);
+            if (keywords.contains(name)) continue;
+            if (next < n && text[next] == '(') return false;   // chamada: qualquer coisa
+            const int slot = resolve(name, false);
+            if (slot < 0) return false;                         // global fora de X/I/O
+            if (!reads.contains(slot)) reads.push_back(slot);
+            continue;
+        }
+        // atribuições e ++/-- escrevem: não é uma leitura pura
+        if (c == '=' ){
+            const bool compare = (i+1 < n && text[i+1] == '=')
+                              || (i > 0 && QString("=!<>").contains(text[i-1]));
+            if (!compare) return false;
+        }
+        if ((c == '+' || c == '-') && i+1 < n && text[i+1] == c) return false;
+        ++i;
+    }
+    return true;
+}
+
+EfsmVm::Result EfsmVm::run(const Program& p, EfsmValue* slots, EfsmValue* result){
+    if (!p.valid) return Result::Fallback;
+
+    QVarLengthArray<EfsmValue, 32> stack(p.maxStack + 1);
+    int sp = 0;   // próximo livre
+
+    // desfaz as escritas se tivermos de cair para o JS no meio da ação
+    QVarLengthArray<QPair<int, EfsmValue>, 8> undo;
+    auto bail = [&](){
+        for (int k = undo.size()-1; k >= 0; --k) slots[undo[k].first] = undo[k].second;
+        return Result::Fallback;
+    };
+
+    const Instr* code = p.code.constData();
+    const int n = p.code.size();
+    for (int pc = 0; pc < n; ++pc){
+        const Instr in = code[pc];
+        switch (in.op){
+        case PushConst:
+            stack[sp++] = p.consts[in.arg];
+            break;
+        case Load: {
+            const EfsmValue& v = slots[in.arg];
+            if (v.type == EfsmValue::String || !safe(v.i)) return bail();
+            stack[sp++] = v;
+            break;
+        }
+        case Store:
+            undo.append(qMakePair(int(in.arg), slots[in.arg]));
+            slots[in.arg] = stack[--sp];
+            break;
+        case Pop:
+            --sp;
+            break;
+        case Not:
+            stack[sp-1] = EfsmValue::fromBool(!stack[sp-1].truthy());
+            break;
+        case Neg:
+            stack[sp-1] = EfsmValue::fromInt(-stack[sp-1].i);
+            break;
+        case Plus:
+            stack[sp-1] = EfsmValue::fromInt(stack[sp-1].i);
+            break;
+        case Add: case Sub: case Mul: case Mod: {
+            const qint64 b = stack[--sp].i;
+            const qint64 a = stack[sp-1].i;
+            qint64 r = 0;
+            if (in.op == Add) r = a + b;           // |a|,|b| <= 2^53: sem overflow
+            else if (in.op == Sub) r = a - b;
+            else if (in.op == Mul) {
+                if (a != 0 && std::llabs(b) > kMaxSafe / std::llabs(a)) return bail();
+                r = a * b;
+            } else {
+                if (b == 0) return bail();         // JS: NaN
+                r = a % b;                         // sinal do dividendo, como no JS
+            }
+            if (!safe(r)) return bail();
+            stack[sp-1] = EfsmValue::fromInt(r);
+            break;
+        }
+        case Lt: case Le: case Gt: case Ge: case Eq: case Ne: {
+            const qint64 b = stack[--sp].i;
+            const qint64 a = stack[sp-1].i;
+            bool r = false;
+            switch (in.op){
+            case Lt: r = a <  b; break;
+            case Le: r = a <= b; break;
+            case Gt: r = a >  b; break;
+            case Ge: r = a >= b; break;
+            case Eq: r = a == b; break;   // bool == número compara numericamente
+            default: r = a != b; break;
+            }
+            stack[sp-1] = EfsmValue::fromBool(r);
+            break;
+        }
+        case StrictEq: case StrictNe: {
+            const EfsmValue b = stack[--sp];
+            const bool eq = (stack[sp-1] == b);
+            stack[sp-1] = EfsmValue::fromBool(in.op == StrictEq ? eq : !eq);
+            break;
+        }
+        case JumpIfFalseKeep:
+            if (!stack[sp-1].truthy()) pc = in.arg - 1;
+            else --sp;
+            break;
+        case JumpIfTrueKeep:
+            if (stack[sp-1].truthy()) pc = in.arg - 1;
+            else --sp;
+            break;
+        }
+    }
+
+    if (p.isGuard && result) *result = stack[sp-1];
+    return Result::Ok;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include "EfsmValue.h"
+#include <QString>
+#include <QVector>
+#include <functional>
+
+// Interpretador de bytecode para o subconjunto "comum" de guardas/ações:
+// literais bool/int, variáveis, ! - +, * %, + -, < <= > >=, == != === !==,
+// && || e atribuições "x := expr" (ou "x = expr") separadas por ';'/linha.
+// A semântica segue o JavaScript (mesmo resultado que o QJSEngine daria):
+// bool vira 0/1 na aritmética, && e || devolvem o operando, etc.
+//
+// Qualquer coisa fora do subconjunto não compila (o chamador usa o JS);
+// em tempo de execução, valores não representáveis (string, |n| > 2^53,
+// % 0) fazem run() devolver Fallback sem alterar nenhum slot.
+// Os slots são os próprios EfsmValue do engine (X | I | O).
+
+class EfsmVm {
+public:
+    enum Op : quint8 {
+        PushConst, Load, Store,
+        Not, Neg, Plus,
+        Add, Sub, Mul, Mod,
+        Lt, Le, Gt, Ge, Eq, Ne, StrictEq, StrictNe,
+        JumpIfFalseKeep,   // && : se falso, pula mantendo o operando; senão descarta
+        JumpIfTrueKeep,    // || : idem, invertido
+        Pop
+    };
+    struct Instr { Op op; qint32 arg; };   // arg: slot, constante ou alvo do salto
+
+    struct Program {
+        QVector<Instr> code;
+        QVector<EfsmValue> consts;
+        QVector<int> reads;    // slots lidos (sem repetição)
+        QVector<int> writes;   // slots escritos (sem repetição)
+        int maxStack = 0;
+        bool isGuard = true;
+        bool valid = false;
+    };
+
+    // Traduz um nome para o índice do slot; -1 = desconhecido (=> JS).
+    // forWrite=true quando o nome é alvo de atribuição.
+    using Resolver = std::function<int(const QString& name, bool forWrite)>;
+
+    static bool compileGuard(const QString& text, const Resolver& resolve, Program& out);
+    static bool compileAction(const QString& text, const Resolver& resolve, Program& out);
+
+    // Conjunto de leitura de uma expressão JS qualquer (para guardas que não
+    // compilam): todos os nomes resolvidos. false se o texto pode depender
+    // de algo além dos slots — chamadas, nomes desconhecidos, atribuições,
+    // templates; nesse caso o resultado não pode ser reaproveitado.
+    static bool readSet(const QString& text, const Resolver& resolve, QVector<int>& reads);
+
+    enum class Result { Ok, Fallback };
+    // Guardas deixam o valor da expressão em *result; ações escrevem nos slots.
+    static Result run(const Program& p, EfsmValue* slots, EfsmValue* result = nullptr);
+};
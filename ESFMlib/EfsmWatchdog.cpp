@@ -0,0 +1,36 @@
+#include "EfsmWatchdog.h"
+#include "EfsmEngine.h"
+#include <chrono>
+
+EfsmWatchdog::EfsmWatchdog(EfsmEngine& engine, qint64 timeoutMs,
+                           const std::atomic<bool>* cancel,
+                           std::function<void()> onTimeout)
+    : engine_(engine), timeoutMs_(timeoutMs), cancel_(cancel), onTimeout_(std::move(onTimeout)),
+      thread_([this](){ loop(); }) {}
+
+EfsmWatchdog::~EfsmWatchdog(){
+    {
+        std::lock_guard<std::mutex> lock(m_);
+        stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+}
+
+void EfsmWatchdog::loop(){
+    std::unique_lock<std::mutex> lock(m_);
+    for (;;){
+        const qint64 timeout = timeoutMs_;
+        const qint64 poll = qBound<qint64>(5, timeout > 0 ? timeout / 4 : 50, 50);
+        if (cv_.wait_for(lock, std::chrono::milliseconds(poll), [this]{ return stop_; })) return;
+
+        const qint64 running = engine_.scriptElapsedNs();
+        if (!running) continue;
+        if (cancel_ && cancel_->load()) { engine_.interruptScript(); continue; }
+        if (timeout > 0 && running >= timeout * 1000000){
+            engine_.interruptScript();
+            ++interrupts_;
+            if (onTimeout_) onTimeout_();
+        }
+    }
+}
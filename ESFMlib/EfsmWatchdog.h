@@ -0,0 +1,43 @@
+#pragma once
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class EfsmEngine;
+
+// Vigia de scripts de um EfsmEngine, numa thread própria: se um script JS
+// passa de timeoutMs, é interrompido (EfsmEngine::interruptScript) e
+// onTimeout é chamado — na thread do vigia. Com cancel, também interrompe o
+// script em curso assim que *cancel fica verdadeiro.
+//
+// O engine não é avisado de nada: o vigia só lê um relógio atômico a cada
+// timeoutMs/4 (entre 5 e 50 ms), então o custo no laço de passos é o de
+// duas escritas atômicas por chamada JS.
+class EfsmWatchdog {
+public:
+    EfsmWatchdog(EfsmEngine& engine, qint64 timeoutMs,
+                 const std::atomic<bool>* cancel = nullptr,
+                 std::function<void()> onTimeout = {});
+    ~EfsmWatchdog();   // para e junta a thread
+
+    void setTimeout(qint64 ms) { timeoutMs_ = ms; }   // <= 0: desligado
+    qint64 timeout() const { return timeoutMs_; }
+    qint64 interrupts() const { return interrupts_; }
+
+private:
+    void loop();
+
+    EfsmEngine& engine_;
+    std::atomic<qint64> timeoutMs_;
+    const std::atomic<bool>* cancel_;
+    std::function<void()> onTimeout_;
+    std::atomic<qint64> interrupts_{0};
+
+    std::mutex m_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
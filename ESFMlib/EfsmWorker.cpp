@@ -0,0 +1,121 @@
+#include "EfsmWorker.h"
+#include "EfsmWatchdog.h"
+#include <QElapsedTimer>
+
+EfsmWorker::EfsmWorker(QObject* parent) : QObject(parent) {
+    qRegisterMetaType<EfsmWorker::Progress>();
+    qRegisterMetaType<EfsmWorker::Result>();
+    // conectado antes de qualquer outro: quem recebe finished() já vê o worker livre
+    connect(this, &EfsmWorker::finished, this, [this](){ busy_ = false; });
+}
+
+EfsmWorker::~EfsmWorker(){
+    cancel_ = true;
+    if (thread_.joinable()) thread_.join();
+}
+
+bool EfsmWorker::start(const EfsmModel& model, const EfsmCheckpoint& from,
+                       const EfsmEngine::RunLimits& limits,
+                       const QVector<EfsmEngine::Breakpoint>& breakpoints,
+                       bool profiling){
+    if (busy_) return false;
+    if (thread_.joinable()) thread_.join();   // a anterior já emitiu finished()
+    busy_ = true;
+    cancel_ = false;
+    {
+        std::lock_guard<std::mutex> lock(editsMutex_);
+        edits_.clear();
+    }
+    thread_ = std::thread([=](){ loop(model, from, limits, breakpoints, profiling); });
+    return true;
+}
+
+void EfsmWorker::cancel(){
+    cancel_ = true;   // o vigia interrompe o script em curso, se houver
+}
+
+void EfsmWorker::edit(int slot, const EfsmValue& value){
+    std::lock_guard<std::mutex> lock(editsMutex_);
+    edits_.push_back(qMakePair(slot, value));
+}
+
+void EfsmWorker::applyEdits(EfsmEngine& engine){
+    QVector<QPair<int, EfsmValue>> edits;
+    {
+        std::lock_guard<std::mutex> lock(editsMutex_);
+        if (edits_.isEmpty()) return;
+        edits.swap(edits_);
+    }
+    const int nx = engine.model().vars.size(), ni = engine.model().inputs.size();
+    for (const auto& e : edits){
+        if (e.first < nx)           engine.setVar(e.first, e.second);
+        else if (e.first < nx + ni) engine.setInput(e.first - nx, e.second);
+        else                        engine.setOutput(e.first - nx - ni, e.second);
+    }
+}
+
+void EfsmWorker::loop(EfsmModel model, EfsmCheckpoint from, EfsmEngine::RunLimits limits,
+                      QVector<EfsmEngine::Breakpoint> breakpoints, bool profiling){
+    QElapsedTimer clock;
+    clock.start();
+    EfsmEngine engine(model);
+    from.apply(engine);
+    engine.setBreakpoints(breakpoints);
+    engine.setProfiling(profiling);
+
+    Result res;
+    EfsmEngine::RunResult& total = res.run;
+    if (limits.stopAtFinal && engine.isFinal()) total.reachedFinal = true;
+    {
+        std::atomic<bool> timedOut{false};
+        EfsmWatchdog dog(engine, scriptTimeoutMs_, &cancel_, [this, &timedOut](){
+            timedOut = true;
+            cancel_ = true;
+        });
+
+        // sem isto, uma condição já verdadeira (a que parou a execução
+        // anterior) dispararia de novo no primeiro passo; sob o vigia porque
+        // a condição pode ser JS
+        engine.primeConditions();
+
+        EfsmEngine::RunLimits slice = limits;
+        slice.cancel = &cancel_;
+        while (!total.reachedFinal && !cancel_){
+            applyEdits(engine);
+            slice.maxMillis = kProgressMs;
+            if (limits.maxSteps >= 0)
+                slice.maxSteps = limits.maxSteps - total.steps;
+            if (limits.maxMillis >= 0)
+                slice.maxMillis = qBound<qint64>(0, limits.maxMillis - clock.elapsed(), kProgressMs);
+
+            const EfsmEngine::RunResult r = engine.run(slice);
+            total.steps += r.steps;
+            total.status = r.status;
+            total.reachedFinal = r.reachedFinal;
+            total.breakpoint = r.breakpoint;
+            total.error = r.error;
+            if (r.transition >= 0) total.transition = r.transition;
+            if (!r.guardError.isEmpty()) total.guardError = r.guardError;
+
+            Progress p;
+            p.steps = engine.stepCount();
+            p.runSteps = total.steps;
+            p.elapsedMs = clock.elapsed();
+            p.state = engine.currentState();
+            for (int k : r.changedVars)    p.vars.push_back(qMakePair(k, engine.var(k)));
+            for (int k : r.changedOutputs) p.outputs.push_back(qMakePair(k, engine.output(k)));
+            emit progress(p);
+
+            if (r.status != EfsmEngine::StepStatus::Fired || r.breakpoint >= 0) break;
+            if (limits.maxSteps >= 0 && total.steps >= limits.maxSteps) break;
+            if (limits.maxMillis >= 0 && clock.elapsed() >= limits.maxMillis) break;
+        }
+        res.timedOut = timedOut;
+    }
+    res.cancelled = cancel_ && !res.timedOut;
+    res.elapsedMs = clock.elapsed();
+    res.guards = engine.guardStats();
+    if (profiling) { res.profile = engine.transitionProfile(); res.stateEntries = engine.stateEntries(); }
+    res.final = EfsmCheckpoint::capture(engine);
+    emit finished(res);
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "EfsmEngine.h"
+#include "EfsmCheckpoint.h"
+#include <QObject>
+#include <QPair>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+// Execução contínua fora da thread da GUI. start() copia o modelo e o ponto
+// de partida (EfsmCheckpoint) para um EfsmEngine que vive só na thread do
+// worker — com o próprio QJSEngine — e volta na hora.
+//
+// A cada fatia de ~kProgressMs a thread emite progress() com o que mudou na
+// fatia; ao terminar, finished() com o resultado e a configuração final. Os
+// sinais são emitidos da thread do worker, então chegam enfileirados aos
+// objetos da GUI. Um EfsmWatchdog interrompe scripts que passem de
+// scriptTimeout() e encerra a execução.
+class EfsmWorker : public QObject {
+    Q_OBJECT
+public:
+    static constexpr qint64 kProgressMs = 50;
+
+    struct Progress {
+        qint64 steps = 0;        // stepCount() do engine do worker
+        qint64 runSteps = 0;     // disparadas nesta execução
+        qint64 elapsedMs = 0;
+        int state = -1;
+        QVector<QPair<int, EfsmValue>> vars;      // (índice em X, valor) alterados na fatia
+        QVector<QPair<int, EfsmValue>> outputs;   // idem em O
+    };
+    struct Result {
+        EfsmEngine::RunResult run;   // steps/status/breakpoint… da execução inteira
+        bool cancelled = false;
+        bool timedOut = false;       // watchdog: script passou do limite
+        qint64 elapsedMs = 0;
+        EfsmEngine::GuardStats guards;
+        QVector<EfsmEngine::TransitionProfile> profile;   // só se start(…, profiling)
+        QVector<qint64> stateEntries;
+        EfsmCheckpoint final;        // configuração ao parar (mesmo layout do modelo)
+    };
+
+    explicit EfsmWorker(QObject* parent = nullptr);
+    ~EfsmWorker() override;   // cancela e junta a thread
+
+    // ocupado de start() até finished() ser entregue na thread do worker (GUI)
+    bool isRunning() const { return busy_; }
+    bool start(const EfsmModel& model, const EfsmCheckpoint& from,
+               const EfsmEngine::RunLimits& limits,
+               const QVector<EfsmEngine::Breakpoint>& breakpoints = {},
+               bool profiling = false);
+    void cancel();
+
+    // edição de X|I|O (índice de slot) vinda da GUI durante a execução:
+    // aplicada no início da próxima fatia
+    void edit(int slot, const EfsmValue& value);
+
+    void setScriptTimeout(qint64 ms) { scriptTimeoutMs_ = ms; }   // <= 0: sem watchdog
+    qint64 scriptTimeout() const { return scriptTimeoutMs_; }
+
+signals:
+    void progress(const EfsmWorker::Progress& p);
+    void finished(const EfsmWorker::Result& r);
+
+private:
+    void loop(EfsmModel model, EfsmCheckpoint from, EfsmEngine::RunLimits limits,
+              QVector<EfsmEngine::Breakpoint> breakpoints, bool profiling);
+    void applyEdits(EfsmEngine& engine);
+
+    bool busy_ = false;
+    std::atomic<bool> cancel_{false};
+    std::atomic<qint64> scriptTimeoutMs_{2000};
+    std::mutex editsMutex_;
+    QVector<QPair<int, EfsmValue>> edits_;
+    std::thread thread_;
+};
+
+Q_DECLARE_METATYPE(EfsmWorker::Progress)
+Q_DECLARE_METATYPE(EfsmWorker::Result)
@@ -13,42 +13,59 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QPushButton>
+#include <QCheckBox>
+#include <QListWidget>
 #include <QHeaderView>
 #include <QInputDialog>
-#include <QtQml/QJSEngine>
-#include <QtQml/QJSValue>
 #include <QMessageBox>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QFile>
 #include <QFileInfo>
+#include <QDir>
 #include <QFileDialog>
+#include <QHash>
 #include <QStatusBar>   // para statusBar()->showMessage(...)
+#include <QTimer>
+#include <QApplication>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QTableWidget>
+#include <QProgressDialog>
+#include <QProgressBar>
+#include "EfsmBatch.h"
+#include "EfsmReplay.h"
+#include "EfsmExplorer.h"
+#include "EfsmCoverage.h"
+#include "EfsmCodegen.h"
+#include "EfsmCheckpoint.h"
 #include <algorithm>    // std::remove_if, std::sort
-#include <cmath>        // std::llround
+#include <limits>       // std::numeric_limits
+#include <numeric>      // std::iota
+#include <thread>
 #include "TransitionItem.h"
 #include "OutputModel.h"
 #include "InputModel.h"   // <-- NOVO
 #include "VarModel.h"
 #include "DiagramScene.h"
+#include "DiagramView.h"
+#include "DiagramMinimap.h"
 #include "TransitionEditorDialog.h"   // <-- necessário para editar via toolbar
 
-
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
 {
     // Cena e view
     scene_ = new DiagramScene(this);
-    view_  = new QGraphicsView(scene_, this);
+    view_  = new DiagramView(scene_, this);
     view_->setRenderHint(QPainter::Antialiasing, true);
     setCentralWidget(view_);
 
-    // Estado inicial
+    // Estado inicial (o sceneRect cresce com o conteúdo: DiagramScene)
     auto* s1 = new StateItem("S1");
     scene_->addItem(s1);
     s1->setPos(0, 0);
-    scene_->setSceneRect(-200, -150, 400, 300);
     // ↓ novo: se for o primeiro, vira inicial
     makeInitialIfNone(s1);
     if (s1->isInitial()) { currentState_ = s1; currentState_->setActive(true); }
@@ -67,6 +84,16 @@ MainWindow::MainWindow(QWidget* parent)
     auto actSave  = tb->addAction("Salvar…");
     connect(actOpen, &QAction::triggered, this, &MainWindow::openModel);
     connect(actSave, &QAction::triggered, this, &MainWindow::saveModel);
+    auto actExportCpp = tb->addAction("Exportar C++…");
+    connect(actExportCpp, &QAction::triggered, this, &MainWindow::exportCpp);
+
+    // Checkpoint da execução (estado, X/I/O, passos): o modelo fica no JSON
+    auto actCheckpoint = tb->addAction("Checkpoint…");
+    connect(actCheckpoint, &QAction::triggered, this, &MainWindow::saveCheckpoint);
+    auto actResume = tb->addAction("Retomar…");
+    connect(actResume, &QAction::triggered, this, &MainWindow::resumeCheckpoint);
+    checkpointTimer_ = new QTimer(this);
+    connect(checkpointTimer_, &QTimer::timeout, this, &MainWindow::writeCheckpoint);
 
     auto actStep = tb->addAction("Step");
     actStep->setShortcut(Qt::Key_F10);
@@ -74,6 +101,61 @@ MainWindow::MainWindow(QWidget* parent)
     addAction(actStep);
     connect(actStep, &QAction::triggered, this, &MainWindow::stepOnce);
 
+    // Histórico: voltar um passo ou ir direto a um passo já executado
+    auto actBack = tb->addAction("Voltar");
+    actBack->setShortcut(QKeySequence(Qt::SHIFT | Qt::Key_F10));
+    actBack->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    addAction(actBack);
+    connect(actBack, &QAction::triggered, this, &MainWindow::stepBack);
+    auto actGoto = tb->addAction("Ir para passo…");
+    connect(actGoto, &QAction::triggered, this, &MainWindow::jumpToStep);
+
+    // Execução contínua: N passos, até o final, ou por T ms
+    auto actRunN = tb->addAction("Executar N…");
+    connect(actRunN, &QAction::triggered, this, &MainWindow::runSteps);
+    auto actRunFinal = tb->addAction("Até o Final");
+    actRunFinal->setShortcut(Qt::Key_F5);
+    actRunFinal->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    addAction(actRunFinal);
+    connect(actRunFinal, &QAction::triggered, this, &MainWindow::runUntilFinal);
+    auto actRunTime = tb->addAction("Executar por…");
+    connect(actRunTime, &QAction::triggered, this, &MainWindow::runForTime);
+    actStop_ = tb->addAction("Parar");
+    actStop_->setShortcut(QKeySequence(Qt::SHIFT | Qt::Key_F5));
+    actStop_->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    actStop_->setEnabled(false);
+    addAction(actStop_);
+    connect(actStop_, &QAction::triggered, this, &MainWindow::stopRun);
+    auto actBatch = tb->addAction("Lote…");
+    connect(actBatch, &QAction::triggered, this, &MainWindow::runBatch);
+    auto actReplay = tb->addAction("Reproduzir…");
+    connect(actReplay, &QAction::triggered, this, &MainWindow::replayTrace);
+    auto actExplore = tb->addAction("Explorar…");
+    connect(actExplore, &QAction::triggered, this, &MainWindow::exploreReachability);
+    auto actTests = tb->addAction("Gerar testes…");
+    connect(actTests, &QAction::triggered, this, &MainWindow::generateTests);
+    runActions_ = { actStep, actBack, actGoto, actRunN, actRunFinal, actRunTime, actBatch, actReplay, actExplore, actTests };
+    auto actWatchdog = tb->addAction("Watchdog…");
+    connect(actWatchdog, &QAction::triggered, this, &MainWindow::setScriptTimeout);
+
+    engine_.setHistory(&history_);
+    watchdog_ = std::make_unique<EfsmWatchdog>(engine_, scriptTimeoutMs_);
+
+    // Execução contínua numa thread própria (com o próprio QJSEngine): a GUI
+    // só aplica os deltas que chegam, então continua editável
+    worker_ = new EfsmWorker(this);
+    worker_->setScriptTimeout(scriptTimeoutMs_);
+    connect(worker_, &EfsmWorker::progress, this, &MainWindow::onRunProgress);
+    connect(worker_, &EfsmWorker::finished, this, &MainWindow::onRunFinished);
+    runProgress_ = new QProgressBar;
+    runProgress_->setMaximumWidth(160);
+    runProgress_->hide();
+    runCancel_ = new QPushButton("Cancelar");
+    runCancel_->hide();
+    statusBar()->addPermanentWidget(runProgress_);
+    statusBar()->addPermanentWidget(runCancel_);
+    connect(runCancel_, &QPushButton::clicked, this, &MainWindow::stopRun);
+
     // Botão para editar transição selecionada
     actEditTransition_ = tb->addAction("Editar Transição");
     actEditTransition_->setEnabled(false);
@@ -88,8 +170,10 @@ MainWindow::MainWindow(QWidget* parent)
         static int count = 1;
         auto* s = new StateItem(QString("S%1").arg(++count));
         scene_->addItem(s);
-        const qreal x = QRandomGenerator::global()->bounded(-100, 101);
-        const qreal y = QRandomGenerator::global()->bounded(-75, 76);
+        // no centro da área visível, com um desvio para não empilhar
+        const QPointF c = view_->visibleSceneRect().center();
+        const qreal x = c.x() + QRandomGenerator::global()->bounded(-100, 101);
+        const qreal y = c.y() + QRandomGenerator::global()->bounded(-75, 76);
         s->setPos(x, y);
 
         // se ainda não há inicial, este passa a ser inicial e corrente
@@ -121,6 +205,17 @@ MainWindow::MainWindow(QWidget* parent)
     tb->addAction(actFinal);
     connect(actFinal, &QAction::triggered, this, &MainWindow::toggleSelectedFinal);
 
+    // Zoom (roda do mouse também; botão do meio ou Espaço+arrastar desloca)
+    auto actZoomIn = tb->addAction("Zoom +");
+    actZoomIn->setShortcut(QKeySequence::ZoomIn);
+    connect(actZoomIn, &QAction::triggered, view_, &DiagramView::zoomIn);
+    auto actZoomOut = tb->addAction("Zoom −");
+    actZoomOut->setShortcut(QKeySequence::ZoomOut);
+    connect(actZoomOut, &QAction::triggered, view_, &DiagramView::zoomOut);
+    auto actFit = tb->addAction("Ajustar");
+    actFit->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_0));
+    connect(actFit, &QAction::triggered, view_, &DiagramView::fitToContent);
+
     // ===== NOVO: Dock de Variáveis =====
     auto dockVars = new QDockWidget("Variáveis (modelo EFSM)", this);
     auto pane = new QWidget;
@@ -223,7 +318,152 @@ MainWindow::MainWindow(QWidget* parent)
     connect(btnAddOut, &QPushButton::clicked, this, &MainWindow::addOutput);
     connect(btnDelOut, &QPushButton::clicked, this, &MainWindow::deleteSelectedOutputs);
 
+    // ===== Dock do Mapa (visão geral + área visível) =====
+    auto dockMap = new QDockWidget("Mapa", this);
+    dockMap->setWidget(new DiagramMinimap(view_));
+    addDockWidget(Qt::RightDockWidgetArea, dockMap);
+
+    // ===== Dock do Perfil (contadores por transição + mapa de calor) =====
+    auto dockProfile = new QDockWidget("Perfil", this);
+    auto paneProf = new QWidget;
+    auto vlayProf = new QVBoxLayout(paneProf);
+    vlayProf->setContentsMargins(6,6,6,6);
+
+    auto hlayProf = new QHBoxLayout;
+    auto chkProfile = new QCheckBox("Medir");
+    auto btnResetProf = new QPushButton("Zerar");
+    hlayProf->addWidget(chkProfile);
+    hlayProf->addWidget(btnResetProf);
+    hlayProf->addStretch(1);
+
+    profileTable_ = new QTableWidget(0, 6);
+    profileTable_->setHorizontalHeaderLabels({ "Transição", "Disparos", "Guardas", "ns/guarda",
+                                               "Guardas (µs)", "Ações (µs)" });
+    profileTable_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    profileTable_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    profileTable_->horizontalHeader()->setStretchLastSection(true);
+    profileTable_->setSortingEnabled(true);
+
+    vlayProf->addLayout(hlayProf);
+    vlayProf->addWidget(profileTable_);
+    paneProf->setLayout(vlayProf);
+    dockProfile->setWidget(paneProf);
+    addDockWidget(Qt::BottomDockWidgetArea, dockProfile);
+
+    profileTimer_ = new QTimer(this);
+    profileTimer_->setInterval(250);   // a cena não precisa de mais que isso
+    connect(profileTimer_, &QTimer::timeout, this, &MainWindow::refreshProfile);
+    connect(chkProfile, &QCheckBox::toggled, this, &MainWindow::setProfiling);
+    connect(btnResetProf, &QPushButton::clicked, this, [this](){
+        engine_.resetProfile();
+        refreshProfile();
+    });
 
+    // ===== Dock de Depuração (breakpoints + watches) =====
+    auto dockDebug = new QDockWidget("Depuração", this);
+    auto paneDbg = new QWidget;
+    auto vlayDbg = new QVBoxLayout(paneDbg);
+    vlayDbg->setContentsMargins(6,6,6,6);
+
+    auto hlayBp = new QHBoxLayout;
+    auto btnBpSel  = new QPushButton("Na seleção");
+    auto btnBpCond = new QPushButton("Condição…");
+    auto btnBpDel  = new QPushButton("Remover");
+    hlayBp->addWidget(btnBpSel);
+    hlayBp->addWidget(btnBpCond);
+    hlayBp->addWidget(btnBpDel);
+    hlayBp->addStretch(1);
+    breakpointList_ = new QListWidget;
+
+    auto hlayWatch = new QHBoxLayout;
+    auto btnWatchAdd = new QPushButton("Watch…");
+    auto btnWatchDel = new QPushButton("Remover");
+    hlayWatch->addWidget(btnWatchAdd);
+    hlayWatch->addWidget(btnWatchDel);
+    hlayWatch->addStretch(1);
+    watchTable_ = new QTableWidget(0, 2);
+    watchTable_->setHorizontalHeaderLabels({ "Expressão", "Valor" });
+    watchTable_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    watchTable_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    watchTable_->horizontalHeader()->setStretchLastSection(true);
+
+    vlayDbg->addLayout(hlayBp);
+    vlayDbg->addWidget(breakpointList_);
+    vlayDbg->addLayout(hlayWatch);
+    vlayDbg->addWidget(watchTable_);
+    paneDbg->setLayout(vlayDbg);
+    dockDebug->setWidget(paneDbg);
+    addDockWidget(Qt::BottomDockWidgetArea, dockDebug);
+
+    connect(btnBpSel,    &QPushButton::clicked, this, &MainWindow::addSelectionBreakpoint);
+    connect(btnBpCond,   &QPushButton::clicked, this, &MainWindow::addConditionBreakpoint);
+    connect(btnBpDel,    &QPushButton::clicked, this, &MainWindow::removeBreakpoint);
+    connect(btnWatchAdd, &QPushButton::clicked, this, &MainWindow::addWatch);
+    connect(btnWatchDel, &QPushButton::clicked, this, &MainWindow::removeWatch);
+
+    // Estrutura do EFSM mudou => o modelo headless precisa ser reconstruído
+    // (e a execução recomeça); renomear ou marcar inicial/final não muda a
+    // topologia nem os scripts, então o engine é atualizado no lugar
+    connect(scene_, &DiagramScene::modelChanged, this, [this](){ modelDirty_ = true; });
+    connect(scene_, &DiagramScene::stateChanged, this, [this](StateItem* s){
+        if (modelDirty_) return;   // syncEngine() relerá tudo
+        const int idx = engineStates_.indexOf(s);
+        if (idx < 0) { modelDirty_ = true; return; }
+        engine_.setStateInfo(idx, s->name(), s->isInitial(), s->isFinal());
+    });
+    connect(scene_, &DiagramScene::transitionScriptChanged, this, [this](TransitionItem* t){
+        if (modelDirty_) return;   // syncEngine() relerá tudo
+        const int idx = engineTransitions_.indexOf(t);
+        if (idx < 0) { modelDirty_ = true; return; }
+        engine_.setGuard(idx, t->guard());
+        engine_.setAction(idx, t->action());
+    });
+    // Transições: o engine mantém a ordem (prioridade, id) de cada estado
+    // incrementalmente, sem reconstruir o modelo
+    connect(scene_, &DiagramScene::transitionAdded, this, [this](TransitionItem* t){
+        if (modelDirty_) return;
+        const int from = engineStates_.indexOf(t->src());
+        const int to   = engineStates_.indexOf(t->dst());
+        if (from < 0 || to < 0) { modelDirty_ = true; return; }
+        engine_.addTransition(toEfsmTransition(t, from, to));
+        engineTransitions_.push_back(t);
+    });
+    connect(scene_, &DiagramScene::transitionRemoved, this, [this](TransitionItem* t){
+        const bool hadBreakpoint = forgetBreakpoints({ t });
+        if (modelDirty_) return;
+        const int idx = engineTransitions_.indexOf(t);
+        if (idx < 0) return;
+        engine_.removeTransition(idx);   // a última ocupa o índice: espelhar
+        engineTransitions_[idx] = engineTransitions_.back();
+        engineTransitions_.pop_back();
+        if (hadBreakpoint) pushBreakpoints();
+    });
+    connect(scene_, &DiagramScene::transitionPriorityChanged, this, [this](TransitionItem* t){
+        if (modelDirty_) return;
+        const int idx = engineTransitions_.indexOf(t);
+        if (idx < 0) { modelDirty_ = true; return; }
+        engine_.setPriority(idx, t->priority());
+    });
+    // Edição de valor numa tabela => só aquele valor é reenviado à sessão JS
+    // (durante uma execução contínua a edição também segue para o worker)
+    auto watchRows = [this](auto* m, auto setter, auto slotOf){
+        connect(m, &QAbstractItemModel::rowsInserted, this, [this](){ modelDirty_ = true; });
+        connect(m, &QAbstractItemModel::rowsRemoved,  this, [this](){ modelDirty_ = true; });
+        connect(m, &QAbstractItemModel::dataChanged, this,
+                [this, m, setter, slotOf](const QModelIndex& tl, const QModelIndex& br){
+            if (tl.column()==0) { modelDirty_ = true; return; }
+            if (modelDirty_) return;   // syncEngine() relerá tudo
+            const bool forward = worker_ && worker_->isRunning() && !applyingProgress_;
+            const auto& rows = m->entries();
+            for (int r=tl.row(); r<=br.row() && r<rows.size(); ++r){
+                (engine_.*setter)(r, rows[r].value);
+                if (forward) worker_->edit(slotOf(r), rows[r].value);
+            }
+        });
+    };
+    watchRows(varModel_,    &EfsmEngine::setVar,    [](int r){ return r; });
+    watchRows(inputModel_,  &EfsmEngine::setInput,  [this](int r){ return engine_.inputSlot(r); });
+    watchRows(outputModel_, &EfsmEngine::setOutput, [this](int r){ return engine_.outputSlot(r); });
 }
 
 void MainWindow::deleteSelected(){
@@ -240,23 +480,22 @@ void MainWindow::deleteSelected(){
         toDelete.push_back(gi);
         if (auto st = dynamic_cast<StateItem*>(gi)){
             // também apaga todas as transições incidentes ao estado
-            for (QGraphicsItem* gj : scene_->items()){
-                if (auto tr = dynamic_cast<TransitionItem*>(gj)){
-                    if (tr->src()==st || tr->dst()==st) toDelete.push_back(tr);
-                }
-            }
+            for (TransitionItem* tr : st->edges()) toDelete.push_back(tr);
         }
     }
     // Remove duplicatas
     std::sort(toDelete.begin(), toDelete.end());
     toDelete.erase(std::unique(toDelete.begin(), toDelete.end()), toDelete.end());
 
+    forgetBreakpoints(toDelete);
+
     // Se o estado corrente será apagado, zere o ponteiro
     for (auto* gi : toDelete){
         if (gi == currentState_) { currentState_ = nullptr; break; }
     }
 
-    // Apaga
+    // Apaga (paralelas que sobram são redistribuídas uma vez, no fim)
+    DiagramScene::GeometryBatch batch(scene_);
     for (auto* gi : toDelete){
         scene_->removeItem(gi);
         delete gi;
@@ -278,9 +517,8 @@ void MainWindow::markSelectedAsInitial(){
     auto* s = dynamic_cast<StateItem*>(sel.front());
     if (!s) return;
 
-    for (QGraphicsItem* gi : scene_->items())
-        if (auto st = dynamic_cast<StateItem*>(gi))
-            st->setInitial(false);
+    for (StateItem* st : scene_->states())
+        st->setInitial(false);
     s->setInitial(true);
 }
 
@@ -308,12 +546,7 @@ void MainWindow::addVariable(){
     const QString valueStr = QInputDialog::getText(this, "Nova variável", "Valor:", QLineEdit::Normal, "", &ok);
     if (!ok) return;
 
-    QVariant parsed;
-    // reaproveita o setData do model: insere linha vazia e edita
-    if (!varModel_->addVar(name, QVariant())) return;
-    // define o valor (usa a mesma lógica do editor de célula)
-    const int row = varModel_->rowCount()-1;
-    varModel_->setData(varModel_->index(row, 1), valueStr, Qt::EditRole);
+    varModel_->addVar(name, EfsmValue::parse(valueStr));
 }
 
 void MainWindow::deleteSelectedVariables(){
@@ -335,9 +568,7 @@ void MainWindow::addInput(){
     const QString valueStr = QInputDialog::getText(this, "Novo input", "Valor:", QLineEdit::Normal, "", &ok);
     if (!ok) return;
 
-    if (!inputModel_->addInput(name, QVariant())) return;
-    const int row = inputModel_->rowCount()-1;
-    inputModel_->setData(inputModel_->index(row, 1), valueStr, Qt::EditRole);
+    inputModel_->addInput(name, EfsmValue::parse(valueStr));
 }
 
 void MainWindow::deleteSelectedInputs(){
@@ -359,9 +590,7 @@ void MainWindow::addOutput(){
     const QString valueStr = QInputDialog::getText(this, "Novo output", "Valor:", QLineEdit::Normal, "", &ok);
     if (!ok) return;
 
-    if (!outputModel_->addOutput(name, QVariant())) return;
-    const int row = outputModel_->rowCount()-1;
-    outputModel_->setData(outputModel_->index(row, 1), valueStr, Qt::EditRole);
+    outputModel_->addOutput(name, EfsmValue::parse(valueStr));
 }
 
 void MainWindow::deleteSelectedOutputs(){
@@ -374,11 +603,7 @@ void MainWindow::deleteSelectedOutputs(){
 }
 
 bool MainWindow::hasInitialState() const {
-    if (!scene_) return false;
-    for (QGraphicsItem* gi : scene_->items())
-        if (auto st = dynamic_cast<StateItem*>(gi))
-            if (st->isInitial()) return true;
-    return false;
+    return findInitial() != nullptr;
 }
 
 void MainWindow::makeInitialIfNone(StateItem* s) {
@@ -391,190 +616,766 @@ void MainWindow::makeInitialIfNone(StateItem* s) {
 
 StateItem* MainWindow::findInitial() const {
     if (!scene_) return nullptr;
-    for (QGraphicsItem* gi : scene_->items())
-        if (auto st = dynamic_cast<StateItem*>(gi))
-            if (st->isInitial()) return st;
+    for (StateItem* st : scene_->states())
+        if (st->isInitial()) return st;
     return nullptr;
 }
 
-static inline QJSValue toJsValue(QJSEngine& eng, const QVariant& v){
-#if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
-    if (v.typeId()==QMetaType::Bool)   return QJSValue(v.toBool());
-    if (v.canConvert<long long>())     return QJSValue((double)v.toLongLong());
-#else
-    if (v.type()==QVariant::Bool)      return QJSValue(v.toBool());
-    if (v.canConvert<qlonglong>())     return QJSValue((double)v.toLongLong());
-#endif
-    return QJSValue(v.toString());
-}
-
-bool MainWindow::buildJsContext(QJSEngine& eng){
-    auto g = eng.globalObject();
-
-    // Vars (X)
-    if (varModel_){
-        for (int r=0; r<varModel_->rowCount(); ++r){
-            const QString name = varModel_->index(r,0).data().toString();
-            const QString sval = varModel_->index(r,1).data().toString();
-            QVariant v = sval; // parse como em setData (bool/int/string)
-            // tenta bool
-            if (sval.compare("true", Qt::CaseInsensitive)==0) v = true;
-            else if (sval.compare("false", Qt::CaseInsensitive)==0) v = false;
-            else {
-                bool ok=false; qlonglong n = sval.toLongLong(&ok);
-                if (ok) v = (qlonglong)n;
-            }
-            g.setProperty(name, toJsValue(eng, v));
-        }
-    }
+EfsmTransition MainWindow::toEfsmTransition(const TransitionItem* t, int from, int to){
+    EfsmTransition et;
+    et.id       = t->id();
+    et.from     = from;
+    et.to       = to;
+    et.priority = t->priority();
+    et.guard    = t->guard();
+    et.action   = t->action();
+    et.label    = t->label();
+    return et;
+}
 
-    // Inputs (I)
-    if (inputModel_){
-        for (int r=0; r<inputModel_->rowCount(); ++r){
-            const QString name = inputModel_->index(r,0).data().toString();
-            const QString sval = inputModel_->index(r,1).data().toString();
-            QVariant v = sval;
-            if (sval.compare("true", Qt::CaseInsensitive)==0) v = true;
-            else if (sval.compare("false", Qt::CaseInsensitive)==0) v = false;
-            else { bool ok=false; qlonglong n = sval.toLongLong(&ok); if (ok) v=(qlonglong)n; }
-            g.setProperty(name, toJsValue(eng, v));
-        }
-    }
+EfsmModel MainWindow::buildModel(QVector<StateItem*>* states,
+                                 QVector<TransitionItem*>* transitions) const {
+    EfsmModel m;
 
-    // Outputs (O) — disponíveis para leitura e passíveis de escrita pela ação
-    if (outputModel_){
-        for (int r=0; r<outputModel_->rowCount(); ++r){
-            const QString name = outputModel_->index(r,0).data().toString();
-            const QString sval = outputModel_->index(r,1).data().toString();
-            QVariant v = sval;
-            if (sval.compare("true", Qt::CaseInsensitive)==0) v = true;
-            else if (sval.compare("false", Qt::CaseInsensitive)==0) v = false;
-            else { bool ok=false; qlonglong n = sval.toLongLong(&ok); if (ok) v=(qlonglong)n; }
-            g.setProperty(name, toJsValue(eng, v));
-        }
-    }
-    return true;
-}
+    // --- Vars / Inputs / Outputs ---
+    auto entriesToVars = [](const auto& entries){
+        QVector<EfsmVar> out;
+        out.reserve(entries.size());
+        for (const auto& e : entries) out.push_back({ e.name, e.value });
+        return out;
+    };
+    if (varModel_)    m.vars    = entriesToVars(varModel_->entries());
+    if (inputModel_)  m.inputs  = entriesToVars(inputModel_->entries());
+    if (outputModel_) m.outputs = entriesToVars(outputModel_->entries());
+    if (!scene_) return m;
 
-bool MainWindow::jsToBool(const QJSValue& v, bool& ok){
-    ok = true;
-    if (v.isBool())   return v.toBool();
-    if (v.isNumber()) return v.toNumber()!=0.0;
-    if (v.isString()){
-        const auto s = v.toString().trimmed();
-        if (s.compare("true", Qt::CaseInsensitive)==0)  return true;
-        if (s.compare("false", Qt::CaseInsensitive)==0) return false;
+    // --- States ---
+    QHash<const StateItem*, int> stateIdx;
+    const auto& sts = scene_->states();
+    m.states.reserve(sts.size());
+    for (StateItem* s : sts){
+        stateIdx.insert(s, m.states.size());
+        EfsmState st;
+        st.name    = s->name();
+        st.x       = s->pos().x();
+        st.y       = s->pos().y();
+        st.initial = s->isInitial();
+        st.final   = s->isFinal();
+        m.states.push_back(st);
     }
-    ok = false; return false;
-}
 
-QString MainWindow::qjsToString(const QJSValue& v){
-    if (v.isBool())   return v.toBool() ? "true" : "false";
-    if (v.isNumber()) return QString::number((qlonglong)std::llround(v.toNumber()));
-    return v.toString();
+    // --- Transitions (ordem de criação/ID) ---
+    QVector<TransitionItem*> ts;
+    ts.reserve(scene_->transitions().size());
+    for (TransitionItem* t : scene_->transitions())
+        if (stateIdx.contains(t->src()) && stateIdx.contains(t->dst())) ts.push_back(t);
+    std::sort(ts.begin(), ts.end(),
+              [](TransitionItem* a, TransitionItem* b){ return a->id() < b->id(); });
+    m.transitions.reserve(ts.size());
+    for (TransitionItem* t : ts)
+        m.transitions.push_back(toEfsmTransition(t, stateIdx.value(t->src()), stateIdx.value(t->dst())));
+    m.rebuildIndex();
+
+    if (states)      *states = sts;
+    if (transitions) *transitions = ts;
+    return m;
 }
 
+void MainWindow::syncEngine(){
+    if (!modelDirty_) return;
+    engine_.setModel(buildModel(&engineStates_, &engineTransitions_));
+    engine_.setCurrentState(engineStates_.indexOf(currentState_));
+    modelDirty_ = false;
+    pushBreakpoints();   // índices novos
+}
 
-void MainWindow::stepOnce(){
-    if (!scene_) return;
+bool MainWindow::prepareEngine(){
+    if (!scene_) return false;
 
     // estado corrente: se ainda não definido, assume o inicial
     if (!currentState_) {
         currentState_ = findInitial();
         if (currentState_) currentState_->setActive(true);
-        if (!currentState_) return; // nada a fazer
+        if (!currentState_) return false; // nada a fazer
+        modelDirty_ = true;               // engine precisa do novo estado corrente
     }
+    syncEngine();   // edições de valor já chegaram via dataChanged
+    return true;
+}
 
-    // 1) Coletar transições saindo do estado corrente
-    struct Cand { int prio; int id; TransitionItem* t; };
-    QVector<Cand> candidates;
+void MainWindow::showEngineValues(const QVector<int>& vars, const QVector<int>& outputs){
+    // Atualizar só as células de Vars e Outputs que mudaram
+    // (inputs não são alterados por ações)
+    for (int k : vars)    varModel_->setValue(k, engine_.var(k));
+    for (int k : outputs) outputModel_->setValue(k, engine_.output(k));
 
-    for (QGraphicsItem* gi : scene_->items()){
-        if (auto t = dynamic_cast<TransitionItem*>(gi)){
-            if (t->src() == currentState_){
-                candidates.push_back({ t->priority(), t->id(), t });
-            }
-        }
-    }
-    if (candidates.isEmpty()) {
+    // Realce do estado corrente
+    StateItem* now = engineStates_.value(engine_.currentState(), nullptr);
+    if (now == currentState_) return;
+    if (currentState_) currentState_->setActive(false);
+    currentState_ = now;
+    if (currentState_) currentState_->setActive(true);
+}
+
+void MainWindow::stepOnce(){
+    if (!prepareEngine()) return;
+
+    const EfsmEngine::StepResult r = engine_.step();
+    if (!r.guardError.isEmpty())
+        statusBar()->showMessage(QString("Erro na guarda: %1").arg(r.guardError), 3000);
+
+    switch (r.status){
+    case EfsmEngine::StepStatus::NoCurrentState:
+        return;
+    case EfsmEngine::StepStatus::NoOutgoing:
         statusBar()->showMessage("Sem transições saindo do estado atual.", 1500);
         return;
+    case EfsmEngine::StepStatus::NoneEnabled:
+        statusBar()->showMessage("Nenhuma transição habilitada.", 1500);
+        return;
+    case EfsmEngine::StepStatus::ActionError:
+        QMessageBox::warning(this, "Erro na ação",
+                             QString("Avaliação da ação falhou:\n%1").arg(r.error));
+        return; // aborta step para não ficar inconsistente
+    case EfsmEngine::StepStatus::Fired:
+        break;
+    }
+
+    // Transitar p/ o estado destino
+    showEngineValues(r.changedVars, r.changedOutputs);
+    refreshWatches();
+    if (r.breakpoint >= 0){
+        statusBar()->showMessage("Breakpoint: " + breakpointLabel(r.breakpoint), 3000);
+        return;
+    }
+    TransitionItem* chosen = engineTransitions_.value(r.transition, nullptr);
+    if (!chosen) return;
+
+    statusBar()->showMessage(
+        QString("Transição: %1 → %2  [p=%3]")
+            .arg(chosen->src()->name())
+            .arg(chosen->dst()->name())
+            .arg(chosen->priority()),
+        2000
+    );
+}
+
+void MainWindow::stepBack(){
+    if (!history_.isEmpty() && history_.cursor() <= history_.firstStep()){
+        statusBar()->showMessage("Início do histórico.", 1500);
+        return;
+    }
+    restoreStep(history_.cursor() - 1);
+}
+
+void MainWindow::jumpToStep(){
+    if (history_.isEmpty()) { statusBar()->showMessage("Histórico vazio.", 1500); return; }
+    bool ok = false;
+    const int step = QInputDialog::getInt(this, "Ir para passo",
+                                          QString("Passo (%1 a %2):").arg(history_.firstStep()).arg(history_.lastStep()),
+                                          int(history_.cursor()), int(history_.firstStep()),
+                                          int(qMin<qint64>(history_.lastStep(), std::numeric_limits<int>::max())),
+                                          1, &ok);
+    if (ok) restoreStep(step);
+}
+
+void MainWindow::restoreStep(qint64 step){
+    if (worker_->isRunning() || !prepareEngine()) return;
+    if (history_.isEmpty()) { statusBar()->showMessage("Histórico vazio.", 1500); return; }
+    if (!history_.restore(step, engine_)) return;
+
+    // o engine já está no passo: tabelas e realce acompanham por inteiro
+    QVector<int> vars(engine_.model().vars.size()), outputs(engine_.model().outputs.size());
+    std::iota(vars.begin(), vars.end(), 0);
+    std::iota(outputs.begin(), outputs.end(), 0);
+    showEngineValues(vars, outputs);
+    refreshWatches();
+
+    const TransitionItem* t = engineTransitions_.value(history_.transitionAt(step), nullptr);
+    statusBar()->showMessage(
+        QString("Passo %1 de %2%3").arg(step).arg(history_.lastStep())
+            .arg(t ? QString(" (via %1 → %2)").arg(t->src()->name(), t->dst()->name()) : QString()),
+        3000
+    );
+}
+
+void MainWindow::runSteps(){
+    bool ok = false;
+    const int n = QInputDialog::getInt(this, "Executar N passos", "Passos:",
+                                       1000, 1, std::numeric_limits<int>::max(), 1, &ok);
+    if (!ok) return;
+    EfsmEngine::RunLimits lim;
+    lim.maxSteps = n;
+    lim.stopAtFinal = false;
+    startRun(lim);
+}
+
+void MainWindow::runUntilFinal(){
+    startRun(EfsmEngine::RunLimits{});   // até estado final ou nenhuma habilitada
+}
+
+void MainWindow::runForTime(){
+    bool ok = false;
+    const int ms = QInputDialog::getInt(this, "Executar por tempo", "Milissegundos:",
+                                        1000, 1, 24*3600*1000, 100, &ok);
+    if (!ok) return;
+    EfsmEngine::RunLimits lim;
+    lim.maxMillis = ms;
+    lim.stopAtFinal = false;
+    startRun(lim);
+}
+
+void MainWindow::startRun(const EfsmEngine::RunLimits& limits){
+    if (worker_->isRunning() || !prepareEngine()) return;
+    runLimits_ = limits;
+    runAbandoned_ = false;
+    // os passos do worker não entram no histórico (ele recomeça no fim)
+    engine_.setHistory(nullptr);
+    worker_->setScriptTimeout(scriptTimeoutMs_);
+    worker_->start(engine_.model(), EfsmCheckpoint::capture(engine_), limits,
+                   engine_.breakpoints(), engine_.profiling());
+
+    for (QAction* a : runActions_) a->setEnabled(false);
+    actStop_->setEnabled(true);
+    // barra determinada com limite de passos/tempo; "ocupada" até o final
+    runProgress_->setRange(0, limits.maxSteps >= 0 || limits.maxMillis >= 0 ? 1000 : 0);
+    runProgress_->setValue(0);
+    runProgress_->show();
+    runCancel_->show();
+    statusBar()->showMessage("Executando…");
+}
+
+void MainWindow::stopRun(){
+    if (worker_->isRunning()) worker_->cancel();   // finished() chega em seguida
+}
+
+void MainWindow::abandonRun(){
+    if (!worker_->isRunning()) return;
+    runAbandoned_ = true;
+    worker_->cancel();
+}
+
+void MainWindow::onRunProgress(const EfsmWorker::Progress& p){
+    if (runAbandoned_) return;
+    if (runLimits_.maxSteps > 0)
+        runProgress_->setValue(int(qMin<qint64>(1000, p.runSteps * 1000 / runLimits_.maxSteps)));
+    else if (runLimits_.maxMillis > 0)
+        runProgress_->setValue(int(qMin<qint64>(1000, p.elapsedMs * 1000 / runLimits_.maxMillis)));
+    statusBar()->showMessage(QString("Executando… %1 passos").arg(p.runSteps));
+    if (modelDirty_) return;   // estrutura editada: os índices do worker não valem mais aqui
+
+    // tabelas -> dataChanged -> engine_: o engine da GUI espelha o do worker
+    applyingProgress_ = true;
+    for (const auto& v : p.vars)    varModel_->setValue(v.first, v.second);
+    for (const auto& v : p.outputs) outputModel_->setValue(v.first, v.second);
+    applyingProgress_ = false;
+    engine_.setCurrentState(p.state);
+    engine_.setStepCount(p.steps);
+    showEngineValues({}, {});   // só o realce do estado
+    refreshWatches();
+}
+
+void MainWindow::onRunFinished(const EfsmWorker::Result& r){
+    for (QAction* a : runActions_) a->setEnabled(true);
+    actStop_->setEnabled(false);
+    runProgress_->hide();
+    runCancel_->hide();
+    if (runAbandoned_){
+        runAbandoned_ = false;
+        engine_.setHistory(&history_);
+        return;
     }
 
-    // 2) Avaliar guardas g(X,I)
-    QJSEngine eng;
-    buildJsContext(eng);
-    auto gobj = eng.globalObject();
-
-    auto enabled = candidates;
-    enabled.erase(std::remove_if(enabled.begin(), enabled.end(), [&](const Cand& c){
-        QString guard = c.t->guard().trimmed();
-        if (guard.isEmpty()) guard = "true";
-        // Avalia a expressão
-        QJSValue res = eng.evaluate(guard);
-        if (res.isError()){
-            // guarda inválida => trata como false e mostra status
-            statusBar()->showMessage(QString("Erro na guarda: %1").arg(res.toString()), 3000);
-            return true; // remove (não habilitada)
+    // configuração final no engine da GUI (se a estrutura ainda é a mesma)
+    QString err;
+    if (prepareEngine() && r.final.apply(engine_, &err)){
+        QVector<int> vars(engine_.model().vars.size()), outputs(engine_.model().outputs.size());
+        std::iota(vars.begin(), vars.end(), 0);
+        std::iota(outputs.begin(), outputs.end(), 0);
+        showEngineValues(vars, outputs);
+        engine_.primeConditions();   // Step logo depois não para de novo na mesma condição
+        engine_.addProfile(r.profile, r.stateEntries);
+        refreshWatches();
+        if (engine_.profiling()) refreshProfile();
+    }
+    engine_.setHistory(&history_);
+    history_.clear();   // recomeça da configuração final
+
+    QString reason;
+    if (r.timedOut)
+        reason = QString("watchdog: script passou de %1 ms").arg(scriptTimeoutMs_);
+    else if (r.cancelled)
+        reason = "interrompida";
+    else switch (r.run.status){
+    case EfsmEngine::StepStatus::NoCurrentState: reason = "sem estado corrente"; break;
+    case EfsmEngine::StepStatus::NoOutgoing:     reason = "sem transições saindo do estado atual"; break;
+    case EfsmEngine::StepStatus::NoneEnabled:    reason = "nenhuma transição habilitada"; break;
+    case EfsmEngine::StepStatus::ActionError:    reason = "erro na ação"; break;
+    case EfsmEngine::StepStatus::Fired:
+        if (r.run.breakpoint >= 0) reason = "breakpoint: " + breakpointLabel(r.run.breakpoint);
+        else if (r.run.reachedFinal) reason = "estado final";
+        else if (runLimits_.maxSteps >= 0 && r.run.steps >= runLimits_.maxSteps) reason = "limite de passos";
+        else reason = "tempo esgotado";
+        break;
+    }
+
+    const qint64 ms = r.elapsedMs;
+    statusBar()->showMessage(
+        QString("Execução: %1 passos em %2 ms (%3 passos/s) — %4 — guardas: %5 avaliadas, %6 do memo")
+            .arg(r.run.steps)
+            .arg(ms)
+            .arg(ms > 0 ? r.run.steps*1000/ms : r.run.steps)
+            .arg(reason)
+            .arg(r.guards.evaluated)
+            .arg(r.guards.cached),
+        5000
+    );
+    if (!err.isEmpty())
+        QMessageBox::warning(this, "Execução", "Resultado não aplicado: " + err);
+    else if (r.run.status == EfsmEngine::StepStatus::ActionError && !r.timedOut)
+        QMessageBox::warning(this, "Erro na ação",
+                             QString("Avaliação da ação falhou:\n%1").arg(r.run.error));
+}
+
+void MainWindow::setScriptTimeout(){
+    bool ok = false;
+    const int ms = QInputDialog::getInt(this, "Watchdog",
+                                        "Tempo máximo de um script JS (ms, 0 = sem limite):",
+                                        scriptTimeoutMs_, 0, 3600*1000, 100, &ok);
+    if (!ok) return;
+    scriptTimeoutMs_ = ms;
+    watchdog_->setTimeout(ms);
+    worker_->setScriptTimeout(ms);   // vale a partir da próxima execução
+}
+
+void MainWindow::setProfiling(bool on){
+    engine_.setProfiling(on);
+    if (on) { profileTimer_->start(); refreshProfile(); return; }
+    profileTimer_->stop();
+    for (TransitionItem* t : scene_->transitions()) t->setHeat(-1, -1);
+    for (StateItem* st : scene_->states()) st->setHeat(-1);
+}
+
+void MainWindow::refreshProfile(){
+    if (modelDirty_) return;   // índices do engine não batem com a cena
+    const auto& prof = engine_.transitionProfile();
+    const auto& entries = engine_.stateEntries();
+
+    // calor relativo ao máximo atual
+    qint64 maxFires = 0, maxNs = 0, maxEntries = 0;
+    for (const auto& p : prof){
+        maxFires = qMax(maxFires, p.fires);
+        maxNs = qMax(maxNs, p.guardNs + p.actionNs);
+    }
+    for (qint64 n : entries) maxEntries = qMax(maxEntries, n);
+    for (int i=0; i<prof.size() && i<engineTransitions_.size(); ++i)
+        engineTransitions_[i]->setHeat(maxFires ? qreal(prof[i].fires) / maxFires : 0,
+                                       maxNs ? qreal(prof[i].guardNs + prof[i].actionNs) / maxNs : 0);
+    for (int i=0; i<entries.size() && i<engineStates_.size(); ++i)
+        engineStates_[i]->setHeat(maxEntries ? qreal(entries[i]) / maxEntries : 0);
+
+    // tabela: números como dados para a ordenação ser numérica
+    profileTable_->setSortingEnabled(false);
+    profileTable_->setRowCount(prof.size());
+    const EfsmModel& m = engine_.model();
+    for (int i=0; i<prof.size(); ++i){
+        const auto& p = prof[i];
+        const auto& t = m.transitions[i];
+        int col = 0;
+        auto put = [&](const QVariant& v){
+            auto* item = new QTableWidgetItem;
+            item->setData(Qt::DisplayRole, v);
+            profileTable_->setItem(i, col++, item);
+        };
+        put(QString("%1 → %2 [%3]").arg(m.states[t.from].name, m.states[t.to].name, t.guard));
+        put(p.fires);
+        put(p.guardEvals);
+        put(p.guardEvals ? p.guardNs / p.guardEvals : 0);
+        put(p.guardNs / 1000);
+        put(p.actionNs / 1000);
+    }
+    profileTable_->setSortingEnabled(true);
+}
+
+bool MainWindow::forgetBreakpoints(const QVector<QGraphicsItem*>& items){
+    const int before = breakpoints_.size();
+    for (int i = breakpoints_.size()-1; i >= 0; --i){
+        const DebugBreakpoint& b = breakpoints_[i];
+        if ((b.state && items.contains(b.state)) || (b.transition && items.contains(b.transition))){
+            breakpoints_.remove(i);
+            delete breakpointList_->takeItem(i);
         }
-        bool ok=false; bool b = jsToBool(res, ok);
-        return !ok || !b; // remove se !ok ou !b
-    }), enabled.end());
+    }
+    return breakpoints_.size() != before;
+}
 
-    if (enabled.isEmpty()) {
-        statusBar()->showMessage("Nenhuma transição habilitada.", 1500);
+void MainWindow::pushBreakpoints(){
+    if (modelDirty_) return;   // syncEngine() empurra depois de reconstruir
+    QVector<EfsmEngine::Breakpoint> list;
+    engineBreakpoints_.clear();
+    for (int i=0; i<breakpoints_.size(); ++i){
+        const DebugBreakpoint& b = breakpoints_[i];
+        EfsmEngine::Breakpoint e;
+        e.kind = b.kind;
+        e.condition = b.condition;
+        if (b.state)      e.index = engineStates_.indexOf(b.state);
+        if (b.transition) e.index = engineTransitions_.indexOf(b.transition);
+        if (e.kind != EfsmEngine::Breakpoint::Kind::Condition && e.index < 0) continue;
+        list.push_back(e);
+        engineBreakpoints_.push_back(i);
+    }
+    engine_.setBreakpoints(list);
+}
+
+QString MainWindow::breakpointLabel(int engineIndex) const {
+    const int i = engineBreakpoints_.value(engineIndex, -1);
+    return i >= 0 && i < breakpoints_.size() ? breakpoints_[i].label : QString();
+}
+
+void MainWindow::addSelectionBreakpoint(){
+    const auto sel = scene_->selectedItems();
+    if (sel.size() != 1) { statusBar()->showMessage("Selecione um estado ou uma transição.", 1500); return; }
+    DebugBreakpoint b;
+    if (auto* st = dynamic_cast<StateItem*>(sel.front())){
+        b.kind = EfsmEngine::Breakpoint::Kind::EnterState;
+        b.state = st;
+        b.label = "entra em " + st->name();
+    } else if (auto* t = dynamic_cast<TransitionItem*>(sel.front())){
+        b.kind = EfsmEngine::Breakpoint::Kind::FireTransition;
+        b.transition = t;
+        b.label = QString("dispara %1 → %2").arg(t->src()->name(), t->dst()->name());
+    } else return;
+    breakpoints_.push_back(b);
+    breakpointList_->addItem(b.label);
+    pushBreakpoints();
+}
+
+void MainWindow::addConditionBreakpoint(){
+    bool ok = false;
+    const QString expr = QInputDialog::getText(this, "Breakpoint condicional",
+                                               "Parar quando ficar verdadeira (ex.: credit < 0):",
+                                               QLineEdit::Normal, {}, &ok).trimmed();
+    if (!ok || expr.isEmpty()) return;
+    DebugBreakpoint b;
+    b.kind = EfsmEngine::Breakpoint::Kind::Condition;
+    b.condition = expr;
+    b.label = "quando " + expr;
+    breakpoints_.push_back(b);
+    breakpointList_->addItem(b.label);
+    pushBreakpoints();
+}
+
+void MainWindow::removeBreakpoint(){
+    const int row = breakpointList_->currentRow();
+    if (row < 0 || row >= breakpoints_.size()) return;
+    breakpoints_.remove(row);
+    delete breakpointList_->takeItem(row);
+    pushBreakpoints();
+}
+
+void MainWindow::addWatch(){
+    bool ok = false;
+    const QString expr = QInputDialog::getText(this, "Watch", "Expressão sobre X/I/O:",
+                                               QLineEdit::Normal, {}, &ok).trimmed();
+    if (!ok || expr.isEmpty()) return;
+    watches_ << expr;
+    engine_.setWatches(watches_);
+    refreshWatches();
+}
+
+void MainWindow::removeWatch(){
+    const int row = watchTable_->currentRow();
+    if (row < 0 || row >= watches_.size()) return;
+    watches_.removeAt(row);
+    engine_.setWatches(watches_);
+    refreshWatches();
+}
+
+void MainWindow::refreshWatches(){
+    watchTable_->setRowCount(watches_.size());
+    if (watches_.isEmpty() || modelDirty_) return;
+    QStringList errors;
+    const QVector<EfsmValue> values = engine_.watchValues(&errors);
+    for (int i=0; i<watches_.size(); ++i){
+        watchTable_->setItem(i, 0, new QTableWidgetItem(watches_[i]));
+        watchTable_->setItem(i, 1, new QTableWidgetItem(errors.value(i).isEmpty()
+                                                            ? values[i].toString()
+                                                            : "erro: " + errors[i]));
+    }
+}
+
+void MainWindow::runBatch(){
+    const QString path = QFileDialog::getOpenFileName(this, "Cenários do lote", {}, "Cenários JSON (*.json)");
+    if (path.isEmpty()) return;
+
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, "Erro", "Não foi possível abrir o arquivo.");
         return;
     }
+    QJsonParseError perr;
+    const auto doc = QJsonDocument::fromJson(f.readAll(), &perr);
+    f.close();
+    QVector<EfsmScenario> scenarios;
+    QString err = perr.errorString();
+    if (perr.error != QJsonParseError::NoError ||
+        !EfsmBatch::scenariosFromJson(doc.isArray() ? QJsonValue(doc.array()) : QJsonValue(doc.object()),
+                                      scenarios, &err)){
+        QMessageBox::warning(this, "Erro", err);
+        return;
+    }
+
+    // modelo imutável compartilhado; valores iniciais = tabelas atuais
+    const EfsmModel model = buildModel();
+    QElapsedTimer clock;
+    clock.start();
+
+    // lote numa thread própria; a GUI só acompanha o progresso
+    std::atomic<bool> cancel{false};
+    std::atomic<bool> done{false};
+    std::atomic<int> finished{0};
+    QVector<EfsmScenarioResult> results;
+    std::thread th([&](){
+        results = EfsmBatch::run(model, scenarios, 0, [&](int n, int){ finished = n; }, &cancel);
+        done = true;
+    });
 
-    // 3) Escolher menor prioridade (empate: menor id = mais antiga)
-    std::sort(enabled.begin(), enabled.end(), [](const Cand& a, const Cand& b){
-        if (a.prio != b.prio) return a.prio < b.prio;
-        return a.id < b.id;
+    QProgressDialog progress("Executando cenários…", "Cancelar", 0, scenarios.size(), this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(0);
+    QTimer poll;
+    connect(&poll, &QTimer::timeout, &progress, [&](){
+        progress.setValue(qMin(finished.load(), scenarios.size() - 1));
+        progress.setLabelText(QString("%1 de %2 cenários").arg(finished.load()).arg(scenarios.size()));
+        if (done) progress.accept();
     });
-    TransitionItem* chosen = enabled.front().t;
-
-    // 4) Executar ação a(X,I,O) — atualiza vars/outputs
-    QString action = chosen->action().trimmed();
-    if (!action.isEmpty()){
-        // converte ":=" -> "=" para o JS
-        action.replace(":=", "=");
-        QJSValue res = eng.evaluate(action);
-        if (res.isError()){
-            QMessageBox::warning(this, "Erro na ação",
-                                 QString("Avaliação da ação falhou:\n%1").arg(res.toString()));
-            return; // aborta step para não ficar inconsistente
+    connect(&progress, &QProgressDialog::canceled, &progress, [&](){ cancel = true; });
+    poll.start(100);
+    progress.exec();
+    cancel = true;   // fechado de qualquer jeito: não deixa a thread órfã
+    th.join();
+    const qint64 ms = clock.elapsed();
+    int cancelled = 0;
+    for (const auto& r : results) cancelled += r.cancelled;
+
+    // Resultados: um cenário por linha
+    QStringList header{ "Cenário", "Estado final", "Passos", "Situação" };
+    for (const auto& o : model.outputs) header << o.name;
+    for (const auto& v : model.vars)    header << v.name;
+
+    QDialog dlg(this);
+    dlg.setWindowTitle(QString("Lote: %1 cenários em %2 ms%3").arg(results.size()).arg(ms)
+                           .arg(cancelled ? QString(" (%1 cancelados)").arg(cancelled) : QString()));
+    auto* table = new QTableWidget(results.size(), header.size(), &dlg);
+    table->setHorizontalHeaderLabels(header);
+    table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    auto situation = [](const EfsmScenarioResult& r) -> QString {
+        if (r.cancelled) return "cancelado";
+        if (r.reachedFinal) return "estado final";
+        switch (r.status){
+        case EfsmEngine::StepStatus::NoCurrentState: return "sem estado inicial";
+        case EfsmEngine::StepStatus::NoOutgoing:     return "sem transições";
+        case EfsmEngine::StepStatus::NoneEnabled:    return "nenhuma habilitada";
+        case EfsmEngine::StepStatus::ActionError:    return "erro na ação: " + r.error;
+        case EfsmEngine::StepStatus::Fired:          return "limite de passos";
         }
+        return {};
+    };
+    for (int row=0; row<results.size(); ++row){
+        const auto& r = results[row];
+        int col = 0;
+        auto put = [&](const QString& text){ table->setItem(row, col++, new QTableWidgetItem(text)); };
+        put(r.name);
+        put(r.finalState >= 0 ? model.states[r.finalState].name : QString("-"));
+        put(QString::number(r.steps));
+        put(situation(r));
+        for (const auto& v : r.outputs) put(v.toString());
+        for (const auto& v : r.vars)    put(v.toString());
     }
+    table->resizeColumnsToContents();
+
+    auto* buttons = new QDialogButtonBox(QDialogButtonBox::Close, &dlg);
+    connect(buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+    auto* lay = new QVBoxLayout(&dlg);
+    lay->addWidget(table);
+    lay->addWidget(buttons);
+    dlg.resize(800, 400);
+    dlg.exec();
+}
 
-    // Ler de volta novas valuations para Vars e Outputs e atualizar as tabelas
-    if (varModel_){
-        for (int r=0; r<varModel_->rowCount(); ++r){
-            const QString name = varModel_->index(r,0).data().toString();
-            QJSValue v = gobj.property(name);
-            varModel_->setData(varModel_->index(r,1), qjsToString(v), Qt::EditRole);
-        }
+void MainWindow::replayTrace(){
+    const QString inPath = QFileDialog::getOpenFileName(this, "Roteiro de inputs", {},
+                                                        "Roteiro (*.csv *.jsonl);;Todos (*)");
+    if (inPath.isEmpty()) return;
+    QFileDialog outDlg(this, "Salvar mudanças de X/O", QFileInfo(inPath).completeBaseName() + ".out.jsonl",
+                       "JSON Lines (*.jsonl)");
+    outDlg.setAcceptMode(QFileDialog::AcceptSave);
+    outDlg.setDefaultSuffix("jsonl");
+    if (outDlg.exec() != QDialog::Accepted) return;
+    const QString outPath = outDlg.selectedFiles().value(0);
+
+    QFile in(inPath), out(outPath);
+    if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QMessageBox::warning(this, "Erro", "Não foi possível abrir os arquivos do roteiro.");
+        return;
     }
-    if (outputModel_){
-        for (int r=0; r<outputModel_->rowCount(); ++r){
-            const QString name = outputModel_->index(r,0).data().toString();
-            QJSValue v = gobj.property(name);
-            outputModel_->setData(outputModel_->index(r,1), qjsToString(v), Qt::EditRole);
-        }
+
+    // parte do estado inicial e dos valores atuais das tabelas; a reprodução
+    // roda numa thread própria, a GUI só acompanha o progresso
+    const EfsmModel model = buildModel();
+    const qint64 total = qMax<qint64>(1, in.size());
+    std::atomic<bool> cancel{false};
+    std::atomic<bool> done{false};
+    std::atomic<qint64> rows{0}, steps{0}, bytesRead{0};
+    EfsmReplay::Stats st;
+    std::thread th([&](){
+        st = EfsmReplay::run(model, in, out, EfsmReplay::Options(), [&](const EfsmReplay::Progress& p){
+            rows = p.rows;
+            steps = p.steps;
+            bytesRead = p.bytesRead;
+        }, &cancel);
+        done = true;
+    });
+
+    QProgressDialog dlg("Reproduzindo…", "Cancelar", 0, 1000, this);
+    dlg.setWindowModality(Qt::WindowModal);
+    dlg.setMinimumDuration(0);
+    QTimer poll;
+    connect(&poll, &QTimer::timeout, &dlg, [&](){
+        dlg.setValue(int(qMin<qint64>(999, bytesRead.load() * 1000 / total)));
+        dlg.setLabelText(QString("%1 linhas, %2 transições").arg(rows.load()).arg(steps.load()));
+        if (done) dlg.accept();
+    });
+    connect(&dlg, &QProgressDialog::canceled, &dlg, [&](){ cancel = true; });
+    poll.start(100);
+    dlg.exec();
+    cancel = true;   // fechado de qualquer jeito: não deixa a thread órfã
+    th.join();
+
+    if (!st.writeError.isEmpty())
+        QMessageBox::warning(this, "Reprodução incompleta", st.summary());
+    else
+        QMessageBox::information(this, st.cancelled ? "Reprodução cancelada" : "Reprodução concluída", st.summary());
+}
+
+void MainWindow::exploreReachability(){
+    const QString path = QFileDialog::getOpenFileName(this, "Domínio dos inputs", {}, "Domínio JSON (*.json)");
+    if (path.isEmpty()) return;
+
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, "Erro", "Não foi possível abrir o arquivo.");
+        return;
+    }
+    const auto doc = QJsonDocument::fromJson(f.readAll());
+    f.close();
+    const EfsmModel model = buildModel();
+    EfsmExplorer::Options opt;
+    QString err;
+    if (!doc.isObject() || !EfsmExplorer::Options::fromJson(doc.object(), model, opt, &err)){
+        QMessageBox::warning(this, "Erro", err.isEmpty() ? QString("Formato JSON inválido.") : err);
+        return;
     }
-    // (inputs tipicamente não são alterados por ações; mantemos como estão)
 
-    // 5) Transitar p/ o estado destino
-    if (currentState_) currentState_->setActive(false);
-    currentState_ = chosen->dst();
-    if (currentState_) currentState_->setActive(true);
+    // Exploração numa thread própria; a GUI só acompanha o progresso
+    std::atomic<bool> cancel{false};
+    std::atomic<bool> done{false};
+    std::atomic<qint64> seen{0}, frontier{0}, rate{0};
+    EfsmExplorer::Result result;
+    std::thread th([&](){
+        result = EfsmExplorer::explore(model, opt, [&](const EfsmExplorer::Progress& p){
+            seen = p.configurations;
+            frontier = p.frontier;
+            rate = p.perSecond;
+        }, &cancel);
+        done = true;
+    });
 
-    statusBar()->showMessage(
-        QString("Transição: %1 → %2  [p=%3]")
-            .arg(chosen->src()->name())
-            .arg(chosen->dst()->name())
-            .arg(chosen->priority()),
-        2000
-    );
+    QProgressDialog dlg("Explorando…", "Cancelar", 0, 0, this);
+    dlg.setWindowModality(Qt::WindowModal);
+    dlg.setMinimumDuration(0);
+    QTimer poll;
+    connect(&poll, &QTimer::timeout, &dlg, [&](){
+        dlg.setLabelText(QString("%1 configurações, fronteira %2, %3/s")
+                             .arg(seen.load()).arg(frontier.load()).arg(rate.load()));
+        if (done) dlg.accept();
+    });
+    connect(&dlg, &QProgressDialog::canceled, &dlg, [&](){ cancel = true; });
+    poll.start(100);
+    dlg.exec();
+    cancel = true;   // fechado de qualquer jeito: não deixa a thread órfã
+    th.join();
+
+    QMessageBox box(QMessageBox::Information, "Exploração",
+                    QString("%1 configurações alcançáveis%2")
+                        .arg(result.configurations)
+                        .arg(result.complete ? QString() : QString(" (incompleta)")),
+                    QMessageBox::Ok, this);
+    box.setDetailedText(result.summary(model));
+    box.exec();
+}
+
+void MainWindow::generateTests(){
+    const QString path = QFileDialog::getOpenFileName(this, "Domínio dos inputs", {}, "Domínio JSON (*.json)");
+    if (path.isEmpty()) return;
+
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, "Erro", "Não foi possível abrir o arquivo.");
+        return;
+    }
+    const auto doc = QJsonDocument::fromJson(f.readAll());
+    f.close();
+    const EfsmModel model = buildModel();
+    EfsmExplorer::Options opt;
+    QString err;
+    if (!doc.isObject() || !EfsmExplorer::Options::fromJson(doc.object(), model, opt, &err)){
+        QMessageBox::warning(this, "Erro", err.isEmpty() ? QString("Formato JSON inválido.") : err);
+        return;
+    }
+    const QString dir = QFileDialog::getExistingDirectory(this, "Pasta dos testes", QFileInfo(path).absolutePath());
+    if (dir.isEmpty()) return;
+
+    // busca numa thread própria, como em exploreReachability()
+    std::atomic<bool> cancel{false};
+    std::atomic<bool> done{false};
+    EfsmCoverage::Suite suite;
+    std::thread th([&](){
+        suite = EfsmCoverage::generate(model, opt, &cancel);
+        done = true;
+    });
+    QProgressDialog dlg("Procurando caminhos…", "Cancelar", 0, 0, this);
+    dlg.setWindowModality(Qt::WindowModal);
+    dlg.setMinimumDuration(0);
+    QTimer poll;
+    connect(&poll, &QTimer::timeout, &dlg, [&](){ if (done) dlg.accept(); });
+    connect(&dlg, &QProgressDialog::canceled, &dlg, [&](){ cancel = true; });
+    poll.start(100);
+    dlg.exec();
+    cancel = true;
+    th.join();
+
+    // um CSV por teste (EfsmReplay) + todos como cenários de lote
+    const QDir out(dir);
+    bool ok = true;
+    for (int i=0; i<suite.tests.size(); ++i){
+        QFile csv(out.filePath(QString("test_%1.csv").arg(i+1, 3, 10, QChar('0'))));
+        ok = csv.open(QIODevice::WriteOnly | QIODevice::Truncate)
+             && EfsmCoverage::writeCsv(suite, suite.tests[i], csv) && ok;
+    }
+    QFile json(out.filePath("suite.json"));
+    QJsonObject root;
+    root["scenarios"] = EfsmCoverage::toScenarios(suite);
+    ok = json.open(QIODevice::WriteOnly | QIODevice::Truncate)
+         && json.write(QJsonDocument(root).toJson(QJsonDocument::Indented)) >= 0 && ok;
+
+    QMessageBox box(ok ? QMessageBox::Information : QMessageBox::Warning, "Testes de cobertura",
+                    QString("%1 testes cobrem %2 de %3 transições%4")
+                        .arg(suite.tests.size()).arg(suite.covered.count(true)).arg(suite.covered.size())
+                        .arg(ok ? QString() : QString(" (falha ao gravar arquivos)")),
+                    QMessageBox::Ok, this);
+    box.setDetailedText(suite.summary(model));
+    box.exec();
 }
 
 TransitionItem* MainWindow::selectedTransition() const {
@@ -601,185 +1402,76 @@ void MainWindow::editSelectedTransition(){
     }
 }
 
-QJsonValue MainWindow::encodeJsonValue(const QString& s) {
-    const QString t = s.trimmed();
-    if (t.compare("true",  Qt::CaseInsensitive)==0)  return QJsonValue(true);
-    if (t.compare("false", Qt::CaseInsensitive)==0)  return QJsonValue(false);
-    bool ok=false; qlonglong n = t.toLongLong(&ok);
-    if (ok) return QJsonValue((double)n);
-    return QJsonValue(t);
-}
-
-QString MainWindow::decodeJsonValue(const QJsonValue& v) {
-    if (v.isBool())   return v.toBool() ? "true" : "false";
-    if (v.isDouble()) return QString::number((qlonglong)std::llround(v.toDouble()));
-    return v.toString();
-}
-
 QJsonObject MainWindow::toJson() const {
-    QJsonObject root;
-
-    // --- Vars / Inputs / Outputs ---
-    auto mapToArray = [&](auto* model)->QJsonArray{
-        QJsonArray arr;
-        if (!model) return arr;
-        for (int r=0; r<model->rowCount(); ++r){
-            const QString name = model->index(r,0).data().toString();
-            const QString val  = model->index(r,1).data().toString();
-            QJsonObject o; o["name"]=name; o["value"]=encodeJsonValue(val);
-            arr.push_back(o);
-        }
-        return arr;
-    };
-    root["vars"]    = mapToArray(varModel_);
-    root["inputs"]  = mapToArray(inputModel_);
-    root["outputs"] = mapToArray(outputModel_);
-
-    // --- States ---
-    QJsonArray jstates;
-    for (QGraphicsItem* gi : scene_->items()){
-        if (auto s = dynamic_cast<StateItem*>(gi)){
-            QJsonObject o;
-            o["name"]    = s->name();
-            o["x"]       = s->pos().x();
-            o["y"]       = s->pos().y();
-            o["initial"] = s->isInitial();
-            o["final"]   = s->isFinal();
-            jstates.push_back(o);
-        }
-    }
-    root["states"] = jstates;
+    return buildModel().toJson();
+}
 
-    // --- Transitions ---
-    QJsonArray jtrans;
-    // salvar na ordem atual de criação/ID para manter aparência (paralelas/self-loops)
-    QVector<TransitionItem*> ts;
-    for (QGraphicsItem* gi : scene_->items())
-        if (auto t = dynamic_cast<TransitionItem*>(gi)) ts.push_back(t);
-    std::sort(ts.begin(), ts.end(),
-              [](TransitionItem* a, TransitionItem* b){ return a->id() < b->id(); });
+void MainWindow::clearSceneAndTables(){
+    abandonRun();
 
-    for (auto* t : ts){
-        QJsonObject o;
-        o["from"]     = t->src()->name();
-        o["to"]       = t->dst()->name();
-        o["guard"]    = t->guard();
-        o["action"]   = t->action();
-        o["priority"] = t->priority();
-        o["label"]    = t->label();
-        jtrans.push_back(o);
+    // estado corrente (o item será apagado junto com a cena)
+    currentState_ = nullptr;
+    QVector<QGraphicsItem*> items;
+    for (const auto& b : breakpoints_){
+        if (b.state) items.push_back(b.state);
+        if (b.transition) items.push_back(b.transition);
     }
-    root["transitions"] = jtrans;
-
-    return root;
-}
+    forgetBreakpoints(items);
 
-void MainWindow::clearSceneAndTables(){
     // limpa itens da cena
-    for (QGraphicsItem* gi : scene_->items()) scene_->removeItem(gi);
-    // (QGraphicsItem* são ownership da scene se parent==nullptr)
-    // mas garantimos:
-    qDeleteAll(scene_->items());
+    scene_->clearDiagram();
 
     // limpa models (mantém cabeçalhos)
     if (varModel_)    varModel_->removeRows(0, varModel_->rowCount());
     if (inputModel_)  inputModel_->removeRows(0, inputModel_->rowCount());
     if (outputModel_) outputModel_->removeRows(0, outputModel_->rowCount());
-
-    // estado corrente
-    if (currentState_) { currentState_->setActive(false); currentState_ = nullptr; }
+    modelDirty_ = true;
 }
 
 bool MainWindow::loadFromJsonObject(const QJsonObject& root){
+    EfsmModel m;
+    QString err;
+    if (!m.fromJson(root, &err)){
+        QMessageBox::warning(this, "Erro", err);
+        return false;
+    }
+
     clearSceneAndTables();
+    DiagramScene::GeometryBatch batch(scene_);   // cada aresta é traçada uma vez, no fim
 
     // 1) Estados
-    QMap<QString, StateItem*> name2state;
-    const auto jstates = root.value("states").toArray();
-    for (const auto& v : jstates){
-        const auto o = v.toObject();
-        auto* s = new StateItem(o.value("name").toString());
+    QVector<StateItem*> items;
+    items.reserve(m.states.size());
+    for (const auto& st : m.states){
+        auto* s = new StateItem(st.name);
         scene_->addItem(s);
-        s->setPos(o.value("x").toDouble(), o.value("y").toDouble());
-        s->setInitial(o.value("initial").toBool());
-        s->setFinal(o.value("final").toBool());
-        name2state.insert(s->name(), s);
+        s->setPos(st.x, st.y);
+        s->setInitial(st.initial);
+        s->setFinal(st.final);
+        items.push_back(s);
     }
 
     // 2) Transições (na ordem salva)
-    const auto jtrans = root.value("transitions").toArray();
-    for (const auto& v : jtrans){
-        const auto o = v.toObject();
-        auto* src = name2state.value(o.value("from").toString(), nullptr);
-        auto* dst = name2state.value(o.value("to").toString(),   nullptr);
-        if (!src || !dst) continue;
-        auto* t = new TransitionItem(src, dst);
+    for (const auto& et : m.transitions){
+        auto* t = new TransitionItem(items[et.from], items[et.to]);
         scene_->addItem(t);
-        t->setPriority(o.value("priority").toInt(1));
-        t->setGuard(o.value("guard").toString("true"));
-        t->setAction(o.value("action").toString());
-        t->setLabel(o.value("label").toString());
-        t->updatePath();
+        t->setPriority(et.priority);
+        t->setGuard(et.guard);
+        t->setAction(et.action);
+        t->setLabel(et.label);
     }
 
     // 3) Vars / Inputs / Outputs
-    auto loadArrayToModel = [&](const char* key, auto* model){
-        if (!model) return;
-        const auto arr = root.value(key).toArray();
-        for (const auto& v : arr){
-            const auto o = v.toObject();
-            const QString name = o.value("name").toString();
-            const QString sval = decodeJsonValue(o.value("value"));
-            model->addXXX(name, QVariant()); // veremos logo abaixo a “ponte”
-            const int row = model->rowCount()-1;
-            model->setData(model->index(row,1), sval, Qt::EditRole);
-        }
-    };
-
-    // Como cada model tem um método com nome diferente, chamamos diretamente:
-    // Vars
-    if (varModel_){
-        const auto arr = root.value("vars").toArray();
-        for (const auto& v : arr){
-            const auto o = v.toObject();
-            const QString name = o.value("name").toString();
-            const QString sval = decodeJsonValue(o.value("value"));
-            varModel_->addVar(name, QVariant());
-            const int row = varModel_->rowCount()-1;
-            varModel_->setData(varModel_->index(row,1), sval, Qt::EditRole);
-        }
-    }
-    // Inputs
-    if (inputModel_){
-        const auto arr = root.value("inputs").toArray();
-        for (const auto& v : arr){
-            const auto o = v.toObject();
-            const QString name = o.value("name").toString();
-            const QString sval = decodeJsonValue(o.value("value"));
-            inputModel_->addInput(name, QVariant());
-            const int row = inputModel_->rowCount()-1;
-            inputModel_->setData(inputModel_->index(row,1), sval, Qt::EditRole);
-        }
-    }
-    // Outputs
-    if (outputModel_){
-        const auto arr = root.value("outputs").toArray();
-        for (const auto& v : arr){
-            const auto o = v.toObject();
-            const QString name = o.value("name").toString();
-            const QString sval = decodeJsonValue(o.value("value"));
-            outputModel_->addOutput(name, QVariant());
-            const int row = outputModel_->rowCount()-1;
-            outputModel_->setData(outputModel_->index(row,1), sval, Qt::EditRole);
-        }
-    }
+    for (const auto& v : m.vars)    varModel_->addVar(v.name, v.value);
+    for (const auto& v : m.inputs)  inputModel_->addInput(v.name, v.value);
+    for (const auto& v : m.outputs) outputModel_->addOutput(v.name, v.value);
 
     // 4) estado inicial/corrente
-    currentState_ = nullptr;
-    for (auto* s : name2state)
-        if (s->isInitial()) { currentState_ = s; break; }
+    const int init = m.initialState();
+    currentState_ = (init >= 0) ? items[init] : nullptr;
     if (currentState_) currentState_->setActive(true);
 
+    view_->fitToContent();
     return true;
 }
 
@@ -802,6 +1494,98 @@ void MainWindow::saveModel(){
     statusBar()->showMessage("Modelo salvo em: " + path, 3000);
 }
 
+void MainWindow::exportCpp(){
+    QFileDialog dlg(this, "Exportar C++");
+    dlg.setAcceptMode(QFileDialog::AcceptSave);
+    dlg.setNameFilters({ "Header C++ (*.h *.hpp)" });
+    dlg.setDefaultSuffix("h");
+    if (!dlg.exec()) return;
+
+    // namespace = nome do arquivo (efsm se não der um identificador)
+    const QString path = dlg.selectedFiles().value(0);
+    EfsmCodegen::Options opt;
+    QString ns = QFileInfo(path).completeBaseName();
+    for (QChar& c : ns) if (!(c.isLetterOrNumber() && c.unicode() < 128)) c = '_';
+    if (!ns.isEmpty() && !ns[0].isDigit() && ns[0] != '_') opt.nameSpace = ns;
+    opt.source = QFileInfo(path).fileName();
+
+    const EfsmModel model = buildModel();
+    EfsmCodegen::Report report;
+    const QByteArray code = EfsmCodegen::toCpp(model, opt, &report).toUtf8();
+    QFile f(path);
+    if (!f.open(QIODevice::WriteOnly) || f.write(code) != code.size()) {
+        QMessageBox::warning(this, "Erro", "Não foi possível gravar o arquivo.");
+        return;
+    }
+    if (report.untranslated.isEmpty()){
+        statusBar()->showMessage(QString("C++ exportado em %1 (%2 transições)").arg(path).arg(report.transitions), 3000);
+        return;
+    }
+    QMessageBox box(QMessageBox::Warning, "Exportar C++",
+                    QString("Exportado em %1, mas %2 transição(ões) ficaram de fora do subconjunto "
+                            "bool/int e devolvem Status::Untranslated.").arg(path).arg(report.untranslated.size()),
+                    QMessageBox::Ok, this);
+    box.setDetailedText(report.text(model));
+    box.exec();
+}
+
+void MainWindow::saveCheckpoint(){
+    QFileDialog dlg(this, "Salvar checkpoint");
+    dlg.setAcceptMode(QFileDialog::AcceptSave);
+    dlg.setNameFilters({ "Checkpoint EFSM (*.efck)" });
+    dlg.setDefaultSuffix("efck");
+    if (!dlg.exec()) return;
+    bool ok = false;
+    const int secs = QInputDialog::getInt(this, "Checkpoint", "Repetir a cada (s; 0 = só agora):",
+                                          checkpointTimer_->isActive() ? checkpointTimer_->interval()/1000 : 60,
+                                          0, 24*3600, 10, &ok);
+    if (!ok) return;
+
+    checkpointPath_ = dlg.selectedFiles().value(0);
+    if (!prepareEngine()) return;
+    writeCheckpoint();
+    if (secs > 0) checkpointTimer_->start(secs * 1000);
+    else          checkpointTimer_->stop();
+    statusBar()->showMessage(secs > 0 ? QString("Checkpoint a cada %1 s em: %2").arg(secs).arg(checkpointPath_)
+                                      : QString("Checkpoint salvo em: %1").arg(checkpointPath_), 3000);
+}
+
+void MainWindow::writeCheckpoint(){
+    // chamado também entre fatias de uma execução: só captura (O(1)) e
+    // entrega; a serialização e o disco ficam na thread do gravador
+    if (checkpointPath_.isEmpty() || modelDirty_) return;
+    checkpointWriter_.submit(EfsmCheckpoint::capture(engine_), checkpointPath_);
+    const auto st = checkpointWriter_.stats();
+    if (!st.lastError.isEmpty())
+        statusBar()->showMessage("Falha no checkpoint: " + st.lastError, 3000);
+}
+
+void MainWindow::resumeCheckpoint(){
+    const QString path = QFileDialog::getOpenFileName(this, "Retomar checkpoint", {}, "Checkpoint EFSM (*.efck)");
+    if (path.isEmpty()) return;
+    abandonRun();
+
+    QElapsedTimer clock;
+    clock.start();
+    EfsmCheckpoint cp;
+    QString err;
+    if (!prepareEngine() || !EfsmCheckpoint::load(path, cp, &err, &engine_.model()) || !cp.apply(engine_, &err)){
+        QMessageBox::warning(this, "Erro", err.isEmpty() ? QString("Não foi possível retomar o checkpoint.") : err);
+        return;
+    }
+    history_.clear();   // o histórico recomeça no passo do checkpoint
+
+    QVector<int> vars(engine_.model().vars.size()), outputs(engine_.model().outputs.size());
+    std::iota(vars.begin(), vars.end(), 0);
+    std::iota(outputs.begin(), outputs.end(), 0);
+    showEngineValues(vars, outputs);
+    for (int k=0; k<engine_.model().inputs.size(); ++k) inputModel_->setValue(k, engine_.input(k));
+    refreshWatches();
+
+    statusBar()->showMessage(QString("Checkpoint retomado no passo %1 (%2 ms)")
+                                 .arg(engine_.stepCount()).arg(clock.elapsed()), 3000);
+}
+
 void MainWindow::openModel(){
     const QString path = QFileDialog::getOpenFileName(this, "Abrir modelo", {}, "EFSM JSON (*.json)");
     if (path.isEmpty()) return;
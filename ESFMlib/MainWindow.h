@@ -1,13 +1,27 @@
 #pragma once
 #include <QMainWindow>
-
-class QGraphicsView;
+#include <QVector>
+#include <QElapsedTimer>
+#include "EfsmEngine.h"
+#include "EfsmHistory.h"
+#include "EfsmCheckpoint.h"
+#include "EfsmWorker.h"
+#include "EfsmWatchdog.h"
+#include <memory>
+
+class DiagramView;
 class DiagramScene; // <-- em vez de QGraphicsScene
 class QTableView;
 class VarModel;
 class InputModel;
 class OutputModel;  // <-- NOVO
 class QAction;
+class QTimer;
+class QTableWidget;
+class QListWidget;
+class QProgressBar;
+class QPushButton;
+class QGraphicsItem;
 class StateItem;
 class TransitionItem;
 
@@ -21,6 +35,7 @@ public:
 private slots:
     void saveModel();     // <-- NOVO
     void openModel();
+    void exportCpp();     // header C++ com step() nativo (subconjunto bool/int)
 
     void deleteSelected();
     void markSelectedAsInitial();
@@ -38,29 +53,106 @@ private slots:
     void addOutput();
     void deleteSelectedOutputs();
 
+    void saveCheckpoint();     // agora e, opcionalmente, a cada N segundos
+    void resumeCheckpoint();
     void stepOnce();
+    void stepBack();     // volta um passo no histórico
+    void jumpToStep();   // vai a um passo qualquer ainda no histórico
+    // execução contínua (num EfsmWorker; a GUI recebe os deltas)
+    void runSteps();
+    void runUntilFinal();
+    void runForTime();
+    void stopRun();
+    void setScriptTimeout();   // watchdog de scripts (Step e execução contínua)
+    void runBatch();   // cenários de um JSON, em paralelo, sobre o modelo atual
+    void replayTrace();   // roteiro CSV/JSONL de inputs -> JSONL de mudanças em X/O
+    void exploreReachability();   // configurações alcançáveis para um domínio de inputs
+    void generateTests();         // sequências de inputs que cobrem todas as transições
     void editSelectedTransition();
+    void setProfiling(bool on);   // contadores no engine + mapa de calor na cena
+    void refreshProfile();
+    // breakpoints (estado, transição ou condição) e watches
+    void addSelectionBreakpoint();
+    void addConditionBreakpoint();
+    void removeBreakpoint();
+    void addWatch();
+    void removeWatch();
 
 private:
     bool hasInitialState() const;
     void makeInitialIfNone(StateItem* s);
     StateItem* findInitial() const;
 
-    // helpers do Step
-    bool buildJsContext(class QJSEngine& eng);               // carrega X,I,O
-    static bool jsToBool(const class QJSValue& v, bool& ok); // conversões
-    static QString qjsToString(const class QJSValue& v);
+    // helpers do Step: o modelo headless é reconstruído só quando a estrutura muda
+    static EfsmTransition toEfsmTransition(const TransitionItem* t, int from, int to);
+    EfsmModel buildModel(QVector<StateItem*>* states = nullptr,
+                         QVector<TransitionItem*>* transitions = nullptr) const;
+    void syncEngine();
+    bool prepareEngine();   // estado corrente + syncEngine(); false se não há o que executar
+    void showEngineValues(const QVector<int>& vars, const QVector<int>& outputs);
+    void startRun(const EfsmEngine::RunLimits& limits);
+    void abandonRun();   // cancela e descarta o resultado (cena/engine vão mudar)
+    void onRunProgress(const EfsmWorker::Progress& p);
+    void onRunFinished(const EfsmWorker::Result& r);
+    void restoreStep(qint64 step);
+    void writeCheckpoint();
+    bool forgetBreakpoints(const QVector<QGraphicsItem*>& items);   // itens apagados; true se algum saiu
+    void pushBreakpoints();                                          // lista da UI -> índices do engine
+    QString breakpointLabel(int engineIndex) const;
+    void refreshWatches();
 
     // Helpers p/ seleção (NOVO)
     TransitionItem* selectedTransition() const;
     void updateActionsEnabled();
 
-    QGraphicsView*  view_  = nullptr;
+    DiagramView*    view_  = nullptr;
     DiagramScene*   scene_ = nullptr; // <-- trocado
 
     // NOVO: ponteiro do estado corrente
     StateItem* currentState_ = nullptr;
 
+    // Engine headless + mapeamento índice do modelo -> item da cena
+    EfsmEngine engine_;
+    QVector<StateItem*>      engineStates_;
+    QVector<TransitionItem*> engineTransitions_;
+    bool modelDirty_ = true;
+    EfsmHistory history_;   // alimentado pelo engine a cada passo
+    int scriptTimeoutMs_ = 2000;
+    std::unique_ptr<EfsmWatchdog> watchdog_;   // scripts do engine_ (Step)
+
+    // Depuração: breakpoints referem itens da cena (viram índices no engine)
+    struct DebugBreakpoint {
+        EfsmEngine::Breakpoint::Kind kind = EfsmEngine::Breakpoint::Kind::Condition;
+        StateItem* state = nullptr;
+        TransitionItem* transition = nullptr;
+        QString condition;
+        QString label;
+    };
+    QVector<DebugBreakpoint> breakpoints_;
+    QVector<int> engineBreakpoints_;   // índice no engine -> breakpoints_
+    QListWidget* breakpointList_ = nullptr;
+    QTableWidget* watchTable_ = nullptr;
+    QStringList watches_;
+
+    // Perfil
+    QTableWidget* profileTable_ = nullptr;
+    QTimer* profileTimer_ = nullptr;
+
+    // Checkpoint periódico (gravado fora da thread da GUI)
+    EfsmCheckpointWriter checkpointWriter_;
+    QTimer* checkpointTimer_ = nullptr;
+    QString checkpointPath_;
+
+    // Execução contínua
+    EfsmWorker* worker_ = nullptr;
+    EfsmEngine::RunLimits runLimits_;
+    bool runAbandoned_ = false;
+    bool applyingProgress_ = false;   // deltas do worker não voltam para ele
+    QProgressBar* runProgress_ = nullptr;
+    QPushButton* runCancel_ = nullptr;
+    QVector<QAction*> runActions_;   // Step/Executar…: desabilitados durante a execução
+    QAction* actStop_ = nullptr;
+
     // Variáveis
     QTableView* varTable_ = nullptr;
     VarModel*   varModel_ = nullptr;
@@ -78,8 +170,6 @@ private:
     // helpers de (de)serialização
     QJsonObject toJson() const;                 // <-- NOVO
     bool loadFromJsonObject(const QJsonObject&);// <-- NOVO
-    static QJsonValue encodeJsonValue(const QString& s); // str->json tipado
-    static QString    decodeJsonValue(const QJsonValue& v); // json->str
 
     void clearSceneAndTables();
 };
@@ -6,7 +6,7 @@ bool OutputModel::nameExists(const QString& name) const {
     return false;
 }
 
-bool OutputModel::addOutput(const QString& name, const QVariant& value){
+bool OutputModel::addOutput(const QString& name, const EfsmValue& value){
     if (name.trimmed().isEmpty() || nameExists(name)) return false;
     const int r = rows_.size();
     beginInsertRows(QModelIndex(), r, r);
@@ -18,7 +18,7 @@ bool OutputModel::addOutput(const QString& name, const QVariant& value){
 bool OutputModel::addEmptyRow(){
     const int r = rows_.size();
     beginInsertRows(QModelIndex(), r, r);
-    rows_.push_back({"", QVariant{}});
+    rows_.push_back({"", EfsmValue{}});
     endInsertRows();
     return true;
 }
@@ -43,17 +43,7 @@ QVariant OutputModel::data(const QModelIndex& index, int role) const {
 
     if (role==Qt::DisplayRole || role==Qt::EditRole){
         if (index.column()==0) return e.name;
-
-        // Mostrar bool como "true"/"false", demais como string
-        #if QT_VERSION >= QT_VERSION_CHECK(6,0,0)
-            if (e.value.metaType().id() == QMetaType::Bool)
-        #else
-            if (e.value.type() == QVariant::Bool)
-        #endif
-        {
-            return e.value.toBool() ? "true" : "false";
-        }
-        return e.value.toString();
+        return e.value.toString();   // bool como "true"/"false"
     }
     return {};
 }
@@ -69,16 +59,6 @@ Qt::ItemFlags OutputModel::flags(const QModelIndex& index) const {
     return Qt::ItemIsSelectable | Qt::ItemIsEnabled | Qt::ItemIsEditable;
 }
 
-bool OutputModel::parseValue(const QString& s, QVariant& out){
-    const QString t = s.trimmed();
-    if (t.compare("true", Qt::CaseInsensitive)==0)  { out = true;  return true; }
-    if (t.compare("false", Qt::CaseInsensitive)==0) { out = false; return true; }
-    bool ok=false; qlonglong v = t.toLongLong(&ok);
-    if (ok) { out = static_cast<qlonglong>(v); return true; }
-    out = t; // string livre
-    return true;
-}
-
 bool OutputModel::setData(const QModelIndex& index, const QVariant& value, int role){
     if (!index.isValid() || role!=Qt::EditRole) return false;
     auto &e = rows_[index.row()];
@@ -88,14 +68,22 @@ bool OutputModel::setData(const QModelIndex& index, const QVariant& value, int r
         if (newName != e.name && nameExists(newName)) return false;
         e.name = newName;
     } else {
-        QVariant val;
-        if (!parseValue(value.toString(), val)) return false;
-        e.value = val;
+        // valor tipado vindo do engine entra direto; texto da edição é analisado
+        e.value = value.userType() == qMetaTypeId<EfsmValue>() ? value.value<EfsmValue>()
+                                                               : EfsmValue::parse(value.toString());
     }
     emit dataChanged(index, index);
     return true;
 }
 
+bool OutputModel::setValue(int row, const EfsmValue& value){
+    if (row<0 || row>=rows_.size() || rows_[row].value == value) return false;
+    rows_[row].value = value;
+    const QModelIndex idx = index(row, 1);
+    emit dataChanged(idx, idx);
+    return true;
+}
+
 bool OutputModel::removeRows(int row, int count, const QModelIndex& parent){
     if (row<0 || count<=0 || row+count>rows_.size()) return false;
     beginRemoveRows(parent, row, row+count-1);
@@ -1,21 +1,24 @@
 #pragma once
 #include <QAbstractTableModel>
 #include <QVariant>
+#include "EfsmValue.h"
 #include <QVector>
 
 class OutputModel : public QAbstractTableModel {
 public:
-    struct Entry { QString name; QVariant value; };
+    struct Entry { QString name; EfsmValue value; };
 
     explicit OutputModel(QObject* parent=nullptr)
         : QAbstractTableModel(parent) {}
 
     // API
-    bool addOutput(const QString& name, const QVariant& value);
+    bool addOutput(const QString& name, const EfsmValue& value = EfsmValue());
     bool addEmptyRow();
     bool removeRowsByIndices(const QList<int>& rows);
     bool nameExists(const QString& name) const;
-    QVector<Entry> entries() const { return rows_; }
+    const QVector<Entry>& entries() const { return rows_; }
+    // escrita tipada do valor (sem passar por texto); false se não mudou
+    bool setValue(int row, const EfsmValue& value);
 
     // QAbstractTableModel
     int rowCount(const QModelIndex& parent = QModelIndex()) const override { Q_UNUSED(parent); return rows_.size(); }
@@ -27,6 +30,5 @@ public:
     bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
 
 private:
-    static bool parseValue(const QString& s, QVariant& out); // bool, int, ou string
     QVector<Entry> rows_;
 };
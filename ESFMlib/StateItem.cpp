@@ -8,6 +8,7 @@
 #include <QPen>
 #include <QBrush>
 #include "TransitionItem.h"
+#include "DiagramScene.h"
 
 namespace { constexpr qreal R = 50.0; }
 
@@ -29,15 +30,40 @@ StateItem::StateItem(const QString& name, QGraphicsItem* parent)
     updateLabelPos();
 }
 
+StateItem::~StateItem(){
+    // arestas que sobrevivem a este estado (ordem de destruição arbitrária
+    // em clear()/deleteSelected) não podem voltar a apontar para ele
+    for (TransitionItem* t : edges_) t->forgetState(this);
+    if (auto ds = DiagramScene::of(this)) ds->unregisterState(this);
+}
+
+void StateItem::addEdge(TransitionItem* t){
+    if (!edges_.contains(t)) edges_.push_back(t);
+}
+
+void StateItem::removeEdge(TransitionItem* t){
+    const int i = edges_.lastIndexOf(t);
+    if (i < 0) return;
+    edges_[i] = edges_.back();   // a ordem não importa
+    edges_.pop_back();
+}
+
 void StateItem::setActive(bool v){
     active_ = v;
     update();
 }
 
+void StateItem::setHeat(qreal h){
+    if (qFuzzyCompare(h + 2, heat_ + 2)) return;
+    heat_ = h;
+    update();
+}
+
 void StateItem::setName(const QString& s){
     name_ = s;
     label_->setPlainText(name_);
     updateLabelPos();
+    if (auto ds = DiagramScene::of(this)) ds->notifyStateChanged(this);
 }
 
 void StateItem::setInitial(bool v){
@@ -45,11 +71,13 @@ void StateItem::setInitial(bool v){
     // borda azul quando inicial, preta caso contrário
     setPen(QPen(v ? QColor(30,80,200) : Qt::black, v ? 2.2 : 1.5));
     update();
+    if (auto ds = DiagramScene::of(this)) ds->notifyStateChanged(this);
 }
 
 void StateItem::setFinal(bool v){
     final_ = v;
     update(); // o círculo duplo é desenhado em paint()
+    if (auto ds = DiagramScene::of(this)) ds->notifyStateChanged(this);
 }
 
 void StateItem::updateLabelPos(){
@@ -60,14 +88,16 @@ void StateItem::updateLabelPos(){
 }
 
 QVariant StateItem::itemChange(GraphicsItemChange change, const QVariant& value){
-    if (change == QGraphicsItem::ItemPositionHasChanged) {
+    if (change == QGraphicsItem::ItemSceneChange) {
+        if (auto ds = DiagramScene::of(this)) ds->unregisterState(this);   // cena antiga
+    } else if (change == QGraphicsItem::ItemSceneHasChanged) {
+        if (auto ds = DiagramScene::of(this)) ds->registerState(this);     // cena nova
+    } else if (change == QGraphicsItem::ItemPositionHasChanged) {
         updateLabelPos();
-        if (scene()){
-            const auto all = scene()->items();
-            for (QGraphicsItem* gi : all)
-                if (auto t = dynamic_cast<TransitionItem*>(gi))
-                    t->updatePath();
-        }
+        if (auto ds = DiagramScene::of(this)) ds->growToInclude(sceneBoundingRect());
+        // só as arestas deste estado (as paralelas ligam o mesmo par, portanto
+        // também estão aqui), recalculadas uma vez por quadro pela cena
+        for (TransitionItem* t : edges_) t->invalidatePath();
     }
     return QGraphicsEllipseItem::itemChange(change, value);
 }
@@ -95,13 +125,31 @@ void StateItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent* e){
 
 // Desenha o estado; se for "final", desenha um anel interno
 void StateItem::paint(QPainter* p, const QStyleOptionGraphicsItem* o, QWidget* w){
+    const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(p->worldTransform());
+    if (lod < DiagramScene::kLodAggregate) return;   // a cena pinta a densidade
+
     // desenho controlado (em vez do paint da base) para colorir "ativo"
+    QBrush fill = brush();
+    if (heat_ >= 0){
+        // cor base -> laranja conforme a fração de entradas
+        const qreal h = qMin<qreal>(heat_, 1);
+        fill = QColor::fromRgbF((240 + 15*h) / 255.0, (240 - 130*h) / 255.0, (255 - 185*h) / 255.0);
+    }
+    if (active_) fill = QBrush(QColor(255,250,200));
+
+    // de longe: um quadrado com a cor da borda, sem antialias
+    if (lod < DiagramScene::kLodStraight){
+        p->setRenderHint(QPainter::Antialiasing, false);
+        p->fillRect(rect(), active_ || heat_ >= 0 ? fill : QBrush(pen().color()));
+        return;
+    }
+
     p->setPen(pen());
-    p->setBrush(active_ ? QBrush(QColor(255,250,200)) : brush());
+    p->setBrush(fill);
     p->drawEllipse(rect());
 
     // estado final: círculo interno
-    if (final_){
+    if (final_ && lod >= DiagramScene::kLodArrows){
         QPen ringPen = pen();
         ringPen.setWidthF(std::max(1.0, pen().widthF() * 0.8));
         p->setPen(ringPen);
@@ -3,10 +3,13 @@
 #include <QGraphicsTextItem>
 #include <QPainter>                  // para a paint override
 #include <QStyleOptionGraphicsItem>  // idem
+#include <QVector>
+class TransitionItem;
 
 class StateItem : public QGraphicsEllipseItem {
 public:
     explicit StateItem(const QString& name, QGraphicsItem* parent = nullptr);
+    ~StateItem() override;
 
     QString name() const { return name_; }
     void setName(const QString& s);
@@ -21,6 +24,18 @@ public:
     bool isActive() const { return active_; }
     void setActive(bool v);
 
+    // mapa de calor do perfil: preenchimento pela fração de entradas (0..1);
+    // negativo = cor normal
+    void setHeat(qreal h);
+
+    void setLabelVisible(bool v) { label_->setVisible(v); }   // nível de detalhe (DiagramScene)
+
+    // Transições incidentes (self-loop aparece uma vez), mantidas pelo próprio
+    // TransitionItem: mover o estado só refaz estas arestas.
+    const QVector<TransitionItem*>& edges() const { return edges_; }
+    void addEdge(TransitionItem* t);
+    void removeEdge(TransitionItem* t);
+
 protected:
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent* e) override;
     QVariant itemChange(GraphicsItemChange change, const QVariant& value) override;
@@ -34,5 +49,7 @@ private:
     bool initial_ = false;
     bool final_   = false;
     bool active_  = false;        // <- NOVO
+    qreal heat_   = -1.0;
     QBrush baseBrush_{ QColor(240,240,255) }; // <- NOVO
+    QVector<TransitionItem*> edges_;
 };
@@ -1,6 +1,7 @@
 #include "TransitionItem.h"
 #include "TransitionEditorDialog.h"
 #include "StateItem.h"
+#include "DiagramScene.h"
 #include <QGraphicsSceneMouseEvent>
 #include <QGraphicsScene>
 #include <QGraphicsSimpleTextItem>
@@ -13,6 +14,7 @@
 #include <QGraphicsSceneContextMenuEvent>
 #include <QMenu>
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
 
 
 int TransitionItem::s_nextId_ = 0;
@@ -21,18 +23,60 @@ TransitionItem::TransitionItem(StateItem* s, StateItem* d, QGraphicsItem* parent
     : QGraphicsPathItem(parent), src_(s), dst_(d)
 {
     id_ = ++s_nextId_;                    // <- NOVO
+    if (src_) src_->addEdge(this);
+    if (dst_ && dst_ != src_) dst_->addEdge(this);
     setZValue(-1); // atrás dos estados
     setPen(QPen(Qt::black, 1.3));
     setBrush(Qt::black); // preenche a cabeça da seta
     setFlags(QGraphicsItem::ItemIsSelectable);
     text_ = new QGraphicsSimpleTextItem(this);
     text_->setFlag(QGraphicsItem::ItemIgnoresTransformations);
-    updatePath();
-    updateLabel();
+    updateLabel();   // o traçado sai ao entrar na cena (DiagramScene::registerTransition)
     text_->setZValue(10);
 
 }
 
+TransitionItem::~TransitionItem(){
+    if (src_) src_->removeEdge(this);
+    if (dst_ && dst_ != src_) dst_->removeEdge(this);
+    if (auto ds = DiagramScene::of(this)) ds->unregisterTransition(this);
+}
+
+void TransitionItem::forgetState(StateItem* s){
+    if (src_ == s) src_ = nullptr;
+    if (dst_ == s) dst_ = nullptr;
+}
+
+void TransitionItem::setBundleSlot(int index, int count, bool bidirectional){
+    if (index == bundleIndex_ && count == bundleCount_ && bidirectional == bundleBidir_) return;
+    bundleIndex_ = index;
+    bundleCount_ = count;
+    bundleBidir_ = bidirectional;
+    invalidatePath();
+}
+
+void TransitionItem::invalidatePath(){
+    if (auto ds = DiagramScene::of(this)) ds->markGeometryDirty(this);
+    else updatePath();
+}
+
+QVariant TransitionItem::itemChange(GraphicsItemChange change, const QVariant& value){
+    if (change == QGraphicsItem::ItemSceneChange) {
+        if (auto ds = DiagramScene::of(this)) ds->unregisterTransition(this);   // cena antiga
+    } else if (change == QGraphicsItem::ItemSceneHasChanged) {
+        if (auto ds = DiagramScene::of(this)) ds->registerTransition(this);     // cena nova
+    }
+    return QGraphicsPathItem::itemChange(change, value);
+}
+
+void TransitionItem::notifyScriptChanged(){
+    if (auto ds = DiagramScene::of(this)) ds->notifyScriptChanged(this);
+}
+
+void TransitionItem::notifyPriorityChanged(){
+    if (auto ds = DiagramScene::of(this)) ds->notifyPriorityChanged(this);
+}
+
 // ===== utilidades Bezier =====
 QPointF TransitionItem::cubicPoint(const QPointF& p0, const QPointF& p1,
                                    const QPointF& p2, const QPointF& p3, qreal t)
@@ -49,56 +93,17 @@ QPointF TransitionItem::cubicTangent(const QPointF& p0, const QPointF& p1,
 }
 
 qreal TransitionItem::computeParallelOffset() const {
-    if (!scene() || !src_ || !dst_) return 0.0;
-
-    // Defina o par canônico (independente da direção)
-    StateItem* a = src_;
-    StateItem* b = dst_;
-    StateItem* lo = (a < b) ? a : b;
-    StateItem* hi = (a < b) ? b : a;
-
-    // Colete irmãos nas DUAS direções entre o mesmo par {lo,hi}
-    QVector<const TransitionItem*> dirLoHi; // lo -> hi  (direção "canônica")
-    QVector<const TransitionItem*> dirHiLo; // hi -> lo  (direção oposta)
-
-    for (QGraphicsItem* gi : scene()->items()){
-        if (auto t = dynamic_cast<TransitionItem*>(gi)){
-            StateItem* ta = t->src();
-            StateItem* tb = t->dst();
-            StateItem* tlo = (ta < tb) ? ta : tb;
-            StateItem* thi = (ta < tb) ? tb : ta;
-            if (tlo == lo && thi == hi){
-                if (ta == lo && tb == hi) dirLoHi.push_back(t);
-                else                      dirHiLo.push_back(t);
-            }
-        }
-    }
-
-    auto byId = [](const TransitionItem* x, const TransitionItem* y){
-        return x->id() < y->id();
-    };
-    std::sort(dirLoHi.begin(), dirLoHi.end(), byId);
-    std::sort(dirHiLo.begin(), dirHiLo.end(), byId);
-
-    const bool hasBothDirs = (!dirLoHi.isEmpty() && !dirHiLo.isEmpty());
-    const bool isLoHi = (src_ == lo && dst_ == hi);
-
     const qreal base = 40.0;
 
-    if (hasBothDirs) {
+    if (bundleBidir_) {
         // Caso BIDIRECIONAL: cada direção num lado.
         // Use offset POSITIVO (0.5, 1.5, 2.5, ...) — o sinal “espelha” sozinho
         // porque o normal n inverte quando a direção inverte.
-        int idx = isLoHi ? dirLoHi.indexOf(this) : dirHiLo.indexOf(this);
-        qreal magnitude = base * (idx + 0.5); // 0.5, 1.5, 2.5, ...
-        return magnitude; // SEM sinal aqui!
-    } else {
-        // Caso UNIDIRECIONAL: distribui centrado (… -1, 0, +1 …)
-        const auto& v = isLoHi ? dirLoHi : dirHiLo; // só um deles tem elementos
-        if (v.size() <= 1) return 0.0;
-        int idx = v.indexOf(this);
-        return base * (idx - (v.size()-1)/2.0);
+        return base * (bundleIndex_ + 0.5); // SEM sinal aqui!
     }
+    // Caso UNIDIRECIONAL: distribui centrado (… -1, 0, +1 …)
+    if (bundleCount_ <= 1) return 0.0;
+    return base * (bundleIndex_ - (bundleCount_-1)/2.0);
 }
 
 void TransitionItem::updatePath(){
@@ -164,6 +169,8 @@ void TransitionItem::updatePath(){
     headPoly_.clear();
     headPoly_ << p3 << h1 << h2;
 
+    curve_ = p;
+
     // Para o boundingRect/seleção, você pode manter a path "completa"
     QPainterPath all = p;
     all.addPolygon(headPoly_);
@@ -199,7 +206,8 @@ void TransitionItem::updateLabel(){
          " / " +
          (action_.isEmpty() ? "/*no-op*/" : action_);
     text_->setText(t);
-    // posição recalculada em updatePath()
+    // posição recalculada em updatePath(), no próximo quadro
+    if (auto ds = DiagramScene::of(this)) ds->markGeometryDirty(this);
 }
 
 void TransitionItem::mouseDoubleClickEvent(QGraphicsSceneMouseEvent* e){
@@ -242,12 +250,44 @@ void TransitionItem::contextMenuEvent(QGraphicsSceneContextMenuEvent* e){
     e->accept();
 }
 
+void TransitionItem::setHeat(qreal fires, qreal time){
+    if (qFuzzyCompare(fires + 2, heatFires_ + 2) && qFuzzyCompare(time + 2, heatTime_ + 2)) return;
+    heatFires_ = fires;
+    heatTime_ = time;
+    if (fires < 0 || time < 0){
+        setPen(QPen(Qt::black, 1.3));
+        setBrush(Qt::black);
+        return;
+    }
+    // preto -> vermelho conforme o tempo; setPen() já refaz o boundingRect
+    const QColor c = QColor::fromRgbF(0.85 * qBound<qreal>(0, time, 1), 0, 0);
+    setPen(QPen(c, 1.3 + 5.0 * qBound<qreal>(0, fires, 1)));
+    setBrush(c);
+}
+
 void TransitionItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget){
-    // 1) curva sem brush (nada de fill)
+    Q_UNUSED(option); Q_UNUSED(widget);
+    const qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+    if (lod < DiagramScene::kLodAggregate) return;   // a cena pinta a densidade
+
     QPen pen = this->pen();
     if (isSelected()) pen.setWidthF(pen.widthF() + 1.0);
     painter->setPen(pen);
     painter->setBrush(Qt::NoBrush);        // <-- SEM preenchimento na curva
+
+    // de longe: reta borda a borda, sem antialias; self-loops ficam dentro do quadrado
+    if (lod < DiagramScene::kLodStraight){
+        if (isSelfLoop()) return;
+        painter->setRenderHint(QPainter::Antialiasing, false);
+        painter->drawLine(startPt_, endPt_);
+        return;
+    }
+    if (lod < DiagramScene::kLodArrows){
+        painter->drawPath(curve_);         // sem a cabeça
+        return;
+    }
+
+    // 1) curva sem brush (nada de fill)
     painter->drawPath(path());             // path inclui curva + polígono, mas brush é NoBrush
 
     // 2) cabeça da seta preenchida
@@ -259,17 +299,9 @@ void TransitionItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* op
 
 int TransitionItem::selfLoopIndexAndCount(int& total) const {
     total = 0;
-    if (!scene() || !isSelfLoop()) return -1;
-    QVector<const TransitionItem*> siblings;
-    for (QGraphicsItem* gi : scene()->items()){
-        if (auto t = dynamic_cast<TransitionItem*>(gi)){
-            if (t->src()==src_ && t->dst()==dst_) siblings.push_back(t);
-        }
-    }
-    std::sort(siblings.begin(), siblings.end(),
-              [](const TransitionItem* a, const TransitionItem* b){ return a->id() < b->id(); });
-    total = siblings.size();
-    return siblings.indexOf(this);
+    if (!isSelfLoop()) return -1;
+    total = bundleCount_;
+    return bundleIndex_;
 }
 
 void TransitionItem::selfLoopGeometry(QPointF& p0, QPointF& p1, QPointF& p2, QPointF& p3) const {
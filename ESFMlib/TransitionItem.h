@@ -1,10 +1,12 @@
 #pragma once
 #include <QGraphicsPathItem>
+#include <QGraphicsSimpleTextItem>
 class StateItem;
 
 class TransitionItem : public QGraphicsPathItem {
 public:
     explicit TransitionItem(StateItem* src, StateItem* dst, QGraphicsItem* parent=nullptr);
+    ~TransitionItem() override;
 
     StateItem* src() const { return src_; }
     StateItem* dst() const { return dst_; }
@@ -14,28 +16,45 @@ public:
     const QString& action() const { return action_; }
     const QString& label()  const { return label_; }
 
-    void setPriority(int p){ priority_=p; updateLabel(); }
-    void setGuard(const QString& g){ guard_=g; updateLabel(); }
-    void setAction(const QString& a){ action_=a; updateLabel(); }
+    void setPriority(int p){ if (p==priority_) return; priority_=p; updateLabel(); notifyPriorityChanged(); }
+    void setGuard(const QString& g){ if (g==guard_) return; guard_=g; updateLabel(); notifyScriptChanged(); }
+    void setAction(const QString& a){ if (a==action_) return; action_=a; updateLabel(); notifyScriptChanged(); }
     void setLabel(const QString& l){ label_=l; updateLabel(); }
 
     void updatePath(); // recalc line & arrow
+    void invalidatePath(); // recalcula no próximo quadro/fim do lote (DiagramScene)
+
+    // chamado pelo StateItem que está sendo apagado antes desta aresta
+    void forgetState(StateItem* s);
+
+    // posição no feixe do par de estados (DiagramScene::EdgeBundle): índice
+    // na sua direção, tamanho dela e se há arestas no sentido oposto
+    void setBundleSlot(int index, int count, bool bidirectional);
+
+    // mapa de calor do perfil (0..1): espessura = disparos, cor = tempo;
+    // valores negativos voltam ao traço normal
+    void setHeat(qreal fires, qreal time);
+
+    void setLabelVisible(bool v) { text_->setVisible(v); }   // nível de detalhe (DiagramScene)
 
     int id() const { return id_; }    // <- NOVO
 
 protected:
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent* e) override;
     void contextMenuEvent(QGraphicsSceneContextMenuEvent* e) override;
+    QVariant itemChange(GraphicsItemChange change, const QVariant& value) override;
     void paint(QPainter* p, const QStyleOptionGraphicsItem* o, QWidget* w) override; // NOVO (só pra realce)
 
 private:
     void updateLabel();
+    void notifyScriptChanged();   // invalida só o script compilado desta transição
+    void notifyPriorityChanged(); // reordena só a lista do estado de origem
 
     bool isSelfLoop() const { return src_ && dst_ && src_==dst_; }
     qreal computeParallelOffset() const; // desvio para paralelas (px)
 
     // NOVO: organizar irmãos self-loop e geometria
-    int selfLoopIndexAndCount(int& total) const;     // índice do loop entre seus irmãos
+    int selfLoopIndexAndCount(int& total) const;     // índice do loop entre seus irmãos (O(1), do feixe)
     void selfLoopGeometry(QPointF& p0, QPointF& p1, QPointF& p2, QPointF& p3) const;
 
     // util p/ Bezier
@@ -57,6 +76,17 @@ private:
     QPointF endPt_;
 
     QPolygonF headPoly_;        // <-- NOVO: triângulo da cabeça para pintar separado
+    QPainterPath curve_;        // só a curva (sem a cabeça), para os níveis de detalhe menores
+
+    friend class DiagramScene;   // fila de geometria adiada
+    bool pathDirty_{false};
+
+    int bundleIndex_{0};
+    int bundleCount_{1};
+    bool bundleBidir_{false};
+
+    qreal heatFires_{-1.0};
+    qreal heatTime_{-1.0};
 
     int id_{0};
     static int s_nextId_;
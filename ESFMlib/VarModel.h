@@ -1,22 +1,25 @@
 #pragma once
 #include <QAbstractTableModel>
 #include <QVariant>
+#include "EfsmValue.h"
 #include <QVector>
 
 class VarModel : public QAbstractTableModel {
     Q_OBJECT
 public:
-    struct Entry { QString name; QVariant value; };
+    struct Entry { QString name; EfsmValue value; };
 
     explicit VarModel(QObject* parent=nullptr)
         : QAbstractTableModel(parent) {}
 
     // API de conveniência
-    bool addVar(const QString& name, const QVariant& value);
+    bool addVar(const QString& name, const EfsmValue& value = EfsmValue());
     bool addEmptyRow(); // insere linha vazia p/ edição inline
     bool removeRowsByIndices(const QList<int>& rows);
     bool nameExists(const QString& name) const;
-    QVector<Entry> entries() const { return rows_; }
+    const QVector<Entry>& entries() const { return rows_; }
+    // escrita tipada do valor (sem passar por texto); false se não mudou
+    bool setValue(int row, const EfsmValue& value);
 
     // QAbstractTableModel
     int rowCount(const QModelIndex& parent = QModelIndex()) const override { Q_UNUSED(parent); return rows_.size(); }
@@ -28,6 +31,5 @@ public:
     bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
 
 private:
-    static bool parseValue(const QString& s, QVariant& out); // tenta bool, depois int; senão string
     QVector<Entry> rows_;
 };